@@ -0,0 +1,150 @@
+// bench/bench_agents.cpp
+// Scaling of AgentResolver from 1 to N threads on one tick of crowd movement,
+// then CollisionGrid::collidesBatch against per-sphere collides() calls.
+//   bench_agents [map.txt] [agents] [ticks]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AgentResolver.h"
+#include "CollisionGrid.h"
+#include "Map.h"
+#include "ThreadPool.h"
+#include "WallRects.h"
+
+#ifndef MAP_DIR
+#define MAP_DIR "maps"
+#endif
+
+static std::uint64_t hashPositions(const std::vector<glm::vec3>& v) {
+    std::uint64_t h = 1469598103934665603ull;   // FNV-1a over the raw floats
+    const auto* p = reinterpret_cast<const unsigned char*>(v.data());
+    for (std::size_t i = 0; i < v.size() * sizeof(glm::vec3); ++i)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+// collidesBatch must agree with collides() sphere for sphere; returns the
+// number of spheres where they differ
+static std::size_t checkBatch(const char* label, const CollisionGrid& grid,
+                              const std::vector<glm::vec3>& pos,
+                              const std::vector<float>& radii, int reps) {
+    std::vector<std::uint8_t> scalar(pos.size()), batch(pos.size());
+    const bool shared = radii.size() == 1;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r)
+        for (std::size_t i = 0; i < pos.size(); ++i)
+            scalar[i] = grid.collides(pos[i], radii[shared ? 0 : i]);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r)
+        grid.collidesBatch(pos, radii, batch);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double scalarMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+    double batchMs  = std::chrono::duration<double, std::milli>(t2 - t1).count() / reps;
+    std::size_t hits = 0, mismatches = 0;
+    for (std::size_t i = 0; i < pos.size(); ++i) {
+        hits += scalar[i];
+        if (scalar[i] != batch[i]) ++mismatches;
+    }
+    std::printf("%-16s %12.3f %12.3f %8.2fx %9zu %11zu%s\n", label, scalarMs, batchMs,
+                scalarMs / batchMs, hits, mismatches, mismatches ? "  MISMATCH" : "");
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : MAP_DIR "/map.txt";
+    std::size_t agents = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+    int ticks = argc > 3 ? std::atoi(argv[3]) : 20;
+
+    Map map;
+    if (!map.load(path)) {
+        std::fprintf(stderr, "cannot load %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    CollisionGrid grid;
+    grid.build(map, 3.0f);
+
+    // Agents on random floor cells, each taking a long (coarse-tick) step
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> pos, delta;
+    pos.reserve(agents);
+    delta.reserve(agents);
+    while (pos.size() < agents) {
+        int x = int(unit(rng) * map.width()), y = int(unit(rng) * map.height());
+        glm::vec3 p = map.cellCenter(x, y, 1.0f);
+        if (grid.collides(p, 0.45f)) continue;
+        float a = unit(rng) * 6.2831853f;
+        pos.push_back(p);
+        delta.push_back(glm::vec3(std::cos(a), 0.0f, std::sin(a)) * 2.0f);
+    }
+    const float radius = 0.45f;
+    std::vector<glm::vec3> out(agents);
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%zu agents, %d ticks, map %dx%d\n", agents, ticks, map.width(), map.height());
+    std::printf("%8s %12s %9s %18s\n", "threads", "ms/tick", "speedup", "result hash");
+
+    double base = 0.0;
+    std::uint64_t reference = 0;
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    for (unsigned threads : counts) {
+        std::unique_ptr<ThreadPool> pool;
+        if (threads > 1) pool = std::make_unique<ThreadPool>(threads - 1);
+        AgentResolver resolver(pool.get());
+
+        resolver.resolve(grid, pos, delta, std::span<const float>(&radius, 1), out);   // warm-up
+        auto t0 = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t)
+            resolver.resolve(grid, pos, delta, std::span<const float>(&radius, 1), out);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / ticks;
+
+        std::uint64_t h = hashPositions(out);
+        if (threads == 1) { base = ms; reference = h; }
+        std::printf("%8u %12.3f %8.2fx %18llx%s\n", threads, ms, base / ms,
+                    (unsigned long long)h, h == reference ? "" : "  MISMATCH");
+        if (h != reference) return EXIT_FAILURE;
+    }
+
+    // Batched sphere tests: the crowd above one unresolved step ahead at its
+    // shared radius, and the same number of spheres scattered over (and just
+    // past) the map with radii on both sides of the tile-gather cutoff at 1
+    std::vector<glm::vec3> stepped(agents);
+    for (std::size_t i = 0; i < agents; ++i) stepped[i] = pos[i] + delta[i];
+    std::vector<glm::vec3> scattered;
+    std::vector<float> radii;
+    scattered.reserve(agents);
+    radii.reserve(agents);
+    for (std::size_t i = 0; i < agents; ++i) {
+        glm::vec3 p = map.cellCenter(int(unit(rng) * (map.width() + 4)) - 2,
+                                     int(unit(rng) * (map.height() + 4)) - 2, 1.0f);
+        p += glm::vec3(unit(rng) - 0.5f, unit(rng) * 5.0f - 2.5f, unit(rng) - 0.5f) * 2.0f;
+        scattered.push_back(p);
+        radii.push_back(0.05f + unit(rng) * 1.35f);
+    }
+    CollisionGrid boxes;
+    boxes.build(map, mergeWallRects(map), 3.0f);
+
+    std::printf("\n%-16s %12s %12s %9s %9s %11s\n", "collidesBatch", "scalar ms",
+                "batch ms", "speedup", "hits", "mismatches");
+    const std::vector<float> crowdRadius{radius};
+    std::size_t mismatches = 0;
+    mismatches += checkBatch("tiles, crowd", grid, stepped, crowdRadius, ticks);
+    mismatches += checkBatch("tiles, scattered", grid, scattered, radii, ticks);
+    mismatches += checkBatch("boxes, crowd", boxes, stepped, crowdRadius, ticks);
+    mismatches += checkBatch("boxes, scattered", boxes, scattered, radii, ticks);
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
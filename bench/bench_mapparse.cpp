@@ -0,0 +1,86 @@
+// bench/bench_mapparse.cpp
+// Text map parse throughput: Map::parse against a per-character
+// getline reference on a generated map held in memory.
+//   bench_mapparse [megabytes] [repeats]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Map.h"
+
+// The parser Map::load used before: getline per row, a branch per character
+static void parseReference(Map& map, const std::string& text) {
+    std::istringstream in(text);
+    std::vector<std::string> rows;
+    int cols = 0;
+    std::string line;
+    map.zombieSpawns.clear();
+    while (std::getline(in, line)) {
+        int y = (int)rows.size();
+        for (int x = 0; x < (int)line.size(); ++x) {
+            if (line[x] == 'P') map.playerSpawn = {x, y};
+            if (line[x] == 'Z') map.zombieSpawns.push_back({x, y});
+        }
+        cols = std::max(cols, (int)line.size());
+        rows.push_back(std::move(line));
+    }
+    map.walls.resize(cols, (int)rows.size());
+    for (int y = 0; y < (int)rows.size(); ++y)
+        for (int x = 0; x < (int)rows[y].size(); ++x)
+            if (rows[y][x] == '#') map.walls.set(x, y, true);
+}
+
+template <class F>
+static double bestSeconds(int repeats, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    const int repeats           = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // Rows of varying width, ~30% walls and a sprinkling of spawns
+    std::mt19937 rng(7);
+    std::string text;
+    text.reserve(megabytes << 20);
+    while (text.size() < (megabytes << 20)) {
+        int len = 900 + int(rng() % 300);
+        for (int x = 0; x < len; ++x) {
+            unsigned r = rng() % 1000;
+            text += r < 300 ? '#' : r == 300 ? 'Z' : '.';
+        }
+        text += '\n';
+    }
+    text[1] = 'P';
+
+    Map fast, ref;
+    const double tFast = bestSeconds(repeats, [&] { fast.parse(text); });
+    const double tRef  = bestSeconds(1,       [&] { parseReference(ref, text); });
+
+    bool same = fast.width() == ref.width() && fast.height() == ref.height() &&
+                fast.playerSpawn == ref.playerSpawn && fast.zombieSpawns == ref.zombieSpawns &&
+                fast.walls.count() == ref.walls.count();
+    for (int y = 0; same && y < ref.height(); ++y)
+        same = std::equal(fast.walls.row(y), fast.walls.row(y) + fast.walls.wordsPerRow(),
+                          static_cast<const Map&>(ref).walls.row(y));
+
+    const double gb = double(text.size()) / 1e9;
+    std::printf("%zu MB, %dx%d cells, %zu walls, %zu zombies\n", text.size() >> 20,
+                fast.width(), fast.height(), fast.walls.count(), fast.zombieSpawns.size());
+    std::printf("Map::parse   %8.1f ms  %6.2f GB/s\n", tFast * 1e3, gb / tFast);
+    std::printf("reference    %8.1f ms  %6.2f GB/s\n", tRef * 1e3, gb / tRef);
+    std::printf("results %s\n", same ? "match" : "DIFFER");
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
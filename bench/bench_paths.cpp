@@ -0,0 +1,239 @@
+// bench/bench_paths.cpp
+// Path query latency: plain grid A* against JPS (block scans), JPS+ (jump
+// table) and HPA*, on the shipped map and a large generated one. Then a
+// mass re-path through PathService: main-thread cost per frame while the
+// workers answer thousands of requests.
+//   bench_paths [size] [queries] [map]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HierarchicalPathfinder.h"
+#include "JumpPointSearch.h"
+#include "Map.h"
+#include "MapGenerator.h"
+#include "MapRegions.h"
+#include "PathService.h"
+#include "ThreadPool.h"
+
+#ifndef MAP_DIR
+#define MAP_DIR "maps"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static double millis(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static void report(const char* name, std::vector<double>& ms) {
+    std::sort(ms.begin(), ms.end());
+    double sum = 0;
+    for (double m : ms) sum += m;
+    std::printf("  %-22s mean %8.3f ms  p50 %8.3f  p99 %8.3f  max %8.3f\n", name,
+                sum / ms.size(), ms[ms.size() / 2], ms[ms.size() * 99 / 100], ms.back());
+}
+
+// Textbook A* over every cell, same moves and costs as the engine's
+// pathfinders; returns the path cost and counts expanded cells
+struct GridAStar {
+    std::vector<std::uint32_t> g, stamp;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> heap;
+    std::uint32_t generation = 0;
+    std::size_t   expanded = 0;
+
+    std::uint32_t run(const Map& map, glm::ivec2 start, glm::ivec2 goal) {
+        static const int dx[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+        static const int dy[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+        const int w = map.width(), h = map.height();
+        if (g.size() != std::size_t(w) * h) {
+            g.assign(std::size_t(w) * h, 0);
+            stamp.assign(std::size_t(w) * h, 0);
+        }
+        ++generation;
+        auto octile = [&](int x, int y) {
+            int ax = std::abs(x - goal.x), ay = std::abs(y - goal.y);
+            return std::uint64_t(3 * std::min(ax, ay) + 2 * std::abs(ax - ay));
+        };
+        auto free = [&](int x, int y) {
+            return (unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h && !map.isWall(x, y);
+        };
+        heap.clear();
+        const std::uint32_t s = std::uint32_t(start.y * w + start.x);
+        g[s] = 0;
+        stamp[s] = generation;
+        heap.push_back({ octile(start.x, start.y) << 32, s });
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            auto [key, i] = heap.back();
+            heap.pop_back();
+            const int x = int(i % w), y = int(i / w);
+            const std::uint32_t gi = g[i];
+            if ((key >> 32) != gi + octile(x, y)) continue;
+            ++expanded;
+            if (x == goal.x && y == goal.y) return gi;
+            for (int k = 0; k < 8; ++k) {
+                const int nx = x + dx[k], ny = y + dy[k];
+                if (!free(nx, ny) || (k >= 4 && (!free(nx, y) || !free(x, ny)))) continue;
+                const std::uint32_t j = std::uint32_t(ny * w + nx), ng = gi + (k < 4 ? 2 : 3);
+                if (stamp[j] == generation && ng >= g[j]) continue;
+                stamp[j] = generation;
+                g[j] = ng;
+                heap.push_back({ (ng + octile(nx, ny)) << 32, j });
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
+            }
+        }
+        return ~std::uint32_t(0);
+    }
+};
+
+static HierarchicalPathfinder benchMap(const char* name, const Map& map, int queries,
+                                       int aStarQueries, ThreadPool& pool) {
+    std::mt19937 rng(3);
+    const int w = map.width(), h = map.height();
+    MapRegions regions;
+    regions.build(map);
+
+    auto t0 = Clock::now();
+    JumpPointSearch jps;
+    jps.build(map, 0);
+    auto t1 = Clock::now();
+    JumpPointSearch jpsPlus;
+    jpsPlus.build(map, std::size_t(w) * h);
+    auto t2 = Clock::now();
+    HierarchicalPathfinder hpa;
+    hpa.build(map, 16, &pool);
+    auto t3 = Clock::now();
+    std::printf("%s: %dx%d, %zu regions\n", name, w, h, regions.regionCount());
+    std::printf("  JPS  build %7.0f ms, %6.1f MB\n", millis(t0, t1), jps.memoryBytes() / 1048576.0);
+    std::printf("  JPS+ build %7.0f ms, %6.1f MB\n", millis(t1, t2), jpsPlus.memoryBytes() / 1048576.0);
+    std::printf("  HPA* build %7.0f ms, %zu level-0 nodes, %d levels (%u workers)\n",
+                millis(t2, t3), hpa.nodeCount(), hpa.levelCount(), pool.size());
+
+    // Reachable pairs only
+    std::vector<std::pair<glm::ivec2, glm::ivec2>> pairs;
+    for (int tries = 0; (int)pairs.size() < queries && tries < queries * 1000; ++tries) {
+        glm::ivec2 a(rng() % w, rng() % h), b(rng() % w, rng() % h);
+        if (a != b && !map.isWall(a.x, a.y) && regions.sameRegion(a, b)) pairs.push_back({ a, b });
+    }
+    if (pairs.empty()) return hpa;
+
+    GridAStar astar;
+    std::vector<double> astarMs, jpsMs, jpsPlusMs, hpaMs;
+    std::vector<glm::ivec2> cells;
+    std::size_t pathCells = 0, mismatches = 0;
+    for (std::size_t q = 0; q < pairs.size(); ++q) {
+        auto [a, b] = pairs[q];
+        auto q0 = Clock::now();
+        jps.findPath(map, a, b, cells);
+        auto q1 = Clock::now();
+        jpsPlus.findPath(map, a, b, cells);
+        auto q2 = Clock::now();
+        hpa.findRoute(map, a, b, cells);
+        auto q3 = Clock::now();
+        jpsMs.push_back(millis(q0, q1));
+        jpsPlusMs.push_back(millis(q1, q2));
+        hpaMs.push_back(millis(q2, q3));
+
+        jpsPlus.findPath(map, a, b, cells);
+        pathCells += cells.size();
+        if ((int)q < aStarQueries) {
+            std::uint32_t cost = 0;
+            for (std::size_t i = 1; i < cells.size(); ++i)
+                cost += cells[i].x != cells[i - 1].x && cells[i].y != cells[i - 1].y ? 3 : 2;
+            auto q4 = Clock::now();
+            if (astar.run(map, a, b) != cost) ++mismatches;
+            astarMs.push_back(millis(q4, Clock::now()));
+        }
+    }
+    std::printf("  %zu queries, mean path %zu cells\n", pairs.size(), pathCells / pairs.size());
+    if (!astarMs.empty()) {
+        std::printf("  A* %zu expansions per query, %zu path costs differ from JPS+\n",
+                    astar.expanded / astarMs.size(), mismatches);
+        report("A*", astarMs);
+    }
+    report("JPS", jpsMs);
+    report("JPS+", jpsPlusMs);
+    report("HPA* route", hpaMs);
+    return hpa;
+}
+
+// Every agent re-paths in one frame: most toward one spot (coalesced into
+// a flow field), the rest to goals of their own (HPA*). Frames are 16 ms;
+// only tick() and take() run on the frame thread.
+static void benchRepath(const Map& map, const HierarchicalPathfinder& hpa, ThreadPool& pool,
+                        int agents) {
+    std::mt19937 rng(5);
+    const int w = map.width(), h = map.height();
+    auto randomFree = [&] {
+        for (;;) {
+            glm::ivec2 c(rng() % w, rng() % h);
+            if (!map.isWall(c.x, c.y)) return c;
+        }
+    };
+
+    PathService::Settings settings;
+    settings.budgetMs = 4.0;
+    PathService service(map, pool, [&](glm::ivec2 a, glm::ivec2 b, std::vector<glm::ivec2>& cells) {
+        return hpa.findPath(map, a, b, cells);
+    }, settings);
+
+    const glm::ivec2 rally = randomFree();
+    std::vector<PathService::Ticket> tickets;
+    auto s0 = Clock::now();
+    for (int i = 0; i < agents; ++i)
+        tickets.push_back(service.request(randomFree(), i % 10 ? rally : randomFree()));
+    const double submitMs = millis(s0, Clock::now());
+
+    std::vector<double> frameMs;
+    std::vector<glm::ivec2> cells;
+    std::size_t found = 0, open = tickets.size();
+    const auto start = Clock::now();
+    while (open > 0) {
+        const auto f0 = Clock::now();
+        service.tick();
+        for (PathService::Ticket& t : tickets) {
+            if (!t) continue;
+            PathService::Status s = service.take(t, cells);
+            if (s == PathService::Status::Pending) continue;
+            found += s == PathService::Status::Found;
+            t = 0;
+            --open;
+        }
+        const auto f1 = Clock::now();
+        frameMs.push_back(millis(f0, f1));
+        std::this_thread::sleep_until(f0 + std::chrono::microseconds(16667));
+    }
+    std::printf("mass re-path: %d requests (90%% one goal) submitted in %.2f ms, %zu found,"
+                " all done after %zu frames (%.0f ms)\n", agents, submitMs, found,
+                frameMs.size(), millis(start, Clock::now()));
+    report("frame thread per frame", frameMs);
+}
+
+int main(int argc, char** argv) {
+    const int size        = argc > 1 ? std::atoi(argv[1]) : 4096;
+    const int queries     = argc > 2 ? std::atoi(argv[2]) : 500;
+    const std::string path = argc > 3 ? argv[3] : MAP_DIR "/map.txt";
+    ThreadPool pool;
+
+    Map shipped;
+    if (shipped.load(path) && shipped.width() > 0)
+        benchMap(path.c_str(), shipped, queries, queries, pool);
+
+    // Open ground scattered with wall blocks and long broken walls
+    MapGenSettings arena;
+    arena.style = MapStyle::Arena;
+    arena.width = arena.height = size;
+    arena.seed = 11;
+    const Map map = generateMap(arena);
+    // Full-map A* takes far longer per query on the big map; sample it
+    HierarchicalPathfinder hpa = benchMap("generated", map, queries, std::min(queries, 20), pool);
+    benchRepath(map, hpa, pool, 2000);
+    return EXIT_SUCCESS;
+}
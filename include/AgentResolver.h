@@ -0,0 +1,35 @@
+// include/AgentResolver.h
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "CollisionWorld.h"
+
+class ThreadPool;
+
+// Moves large crowds against static collision geometry in parallel.
+// Agents are sorted by coarse spatial cell so each worker walks a compact
+// region of the world. Agents don't interact and the world is read-only,
+// so no locks are taken and out[] is identical whatever the thread count.
+class AgentResolver {
+public:
+    // pool == nullptr resolves on the calling thread
+    explicit AgentResolver(ThreadPool* pool, float cellSize = 8.0f)
+        : pool(pool), cellSize(cellSize) {}
+
+    // out[i] = world.slide(positions[i], deltas[i], radii[i]).
+    // radii may hold a single value shared by every agent.
+    void resolve(const CollisionWorld& world,
+                 std::span<const glm::vec3> positions,
+                 std::span<const glm::vec3> deltas,
+                 std::span<const float> radii,
+                 std::span<glm::vec3> out);
+
+private:
+    ThreadPool*                pool;
+    float                      cellSize;
+    // (Morton cell code << 32 | agent index), reused between ticks
+    std::vector<std::uint64_t> order;
+};
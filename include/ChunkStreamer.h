@@ -0,0 +1,143 @@
+// include/ChunkStreamer.h
+#pragma once
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "WallRects.h"
+
+struct Frustum;
+struct Map;
+class OccupancyGrid;
+class ThreadPool;
+
+// Keeps only the walls around the camera resident, one square chunk of map
+// cells at a time. Chunks are meshed (merged into wall rects and turned into
+// instance matrices) on the worker pool; the render thread uploads finished
+// chunks under a per-frame byte budget and draws the resident ones.
+//
+// Each resident chunk owns one fixed-size slot of the instance buffer, and
+// as many slots exist as fit the byte budget. When every slot is taken, the
+// chunk least recently in range is evicted, so the memory wall instances
+// take on the GPU and CPU stays bounded however large the map is.
+//
+// That bound covers the walls only. The map's occupancy bits stay whole (1
+// bit per cell, mmapped for binary maps), and the per-cell structures built
+// at load (distance field, flow field, visibility set) are not streamed:
+// each is skipped past its own size limit instead. Maps must still fit in
+// memory at 1 bit per cell.
+//
+// With a visible-cell set (see PotentiallyVisibleSet), a slot holds only
+// the chunk's instances that touch a visible cell. Chunks keep their full
+// instance list on the CPU to refill the slot when the set changes; the
+// refills share the per-frame upload budget.
+//
+// Each slot also records the world bounds of what it holds, so drawing
+// skips chunks outside the view frustum: submitted instances follow what
+// the camera looks at, not the size of the map.
+class ChunkStreamer {
+public:
+    struct Settings {
+        int         chunkSize          = 32;          // cells per side
+        int         loadRadius         = 3;           // chunks around the camera's
+        std::size_t maxResidentBytes   = 16 << 20;    // see slotBytes(); raised to fit the load square
+        std::size_t uploadBytesPerFrame = 256 * 1024;
+        float       wallHeight         = 3.0f;
+    };
+
+    // map must outlive the streamer and not change while it runs
+    ChunkStreamer(const Map& map, ThreadPool& pool, const Settings& settings);
+    ~ChunkStreamer();   // waits for in-flight jobs
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Mark the chunks around the camera as wanted and queue jobs for the
+    // missing ones, nearest first
+    void update(const glm::vec3& cameraPos);
+
+    // Draw only instances touching a set cell of cells, or everything for
+    // nullptr. cells must stay alive and unchanged until the next call.
+    void setVisibleCells(const OccupancyGrid* cells);
+
+    // Refill the slots of resident chunks whose visible instances changed,
+    // then hand finished chunks to upload(slot, instances), until this
+    // frame's byte budget is spent (at least one slot per call). A slot
+    // waiting for its refill keeps drawing what it holds.
+    void upload(const std::function<void(std::size_t, const std::vector<glm::mat4>&)>& upload);
+
+    // draw(slot, instanceCount) for every resident chunk with visible walls
+    // whose bounds touch the frustum; returns the instances drawn
+    std::size_t forEachResident(const Frustum& frustum,
+                                const std::function<void(std::size_t, std::size_t)>& draw) const;
+
+    // Instances per slot: merged rects never outnumber a chunk's cells
+    std::size_t slotCapacity() const { return std::size_t(settings.chunkSize) * settings.chunkSize; }
+    std::size_t slotCount() const    { return slots; }
+    // Worst-case bytes one resident chunk holds: its slot of the GPU buffer
+    // plus the rects and instances kept on the CPU to refill it
+    std::size_t slotBytes() const {
+        return slotCapacity() * (2 * sizeof(glm::mat4) + sizeof(WallRect));
+    }
+    std::size_t residentCount() const;
+    // Instances in resident slots, before frustum culling
+    std::size_t drawnInstanceCount() const;
+
+private:
+    static constexpr std::size_t kNoSlot = ~std::size_t(0);
+
+    struct Chunk {
+        bool          resident   = false;   // false: job queued or running
+        std::size_t   slot       = kNoSlot; // kNoSlot for chunks without walls
+        std::size_t   count      = 0;       // instances in the slot
+        std::uint64_t lastWanted = 0;       // frame it was last in range
+        std::uint64_t shown      = 0;       // visibility the slot was filled for
+        glm::vec3     lo{ 0.0f }, hi{ 0.0f };  // world bounds of the slot's instances
+        std::vector<WallRect>  rects;       // all of the chunk's, CPU side
+        std::vector<glm::mat4> instances;
+    };
+
+    struct Built {
+        std::uint64_t          key;
+        std::vector<WallRect>  rects;
+        std::vector<glm::mat4> instances;
+    };
+
+    // Shared with the jobs so they never touch the streamer itself
+    struct Results {
+        std::mutex              mutex;
+        std::condition_variable idle;
+        std::deque<Built>       ready;
+        int                     inFlight = 0;
+    };
+
+    static std::uint64_t chunkKey(int cx, int cy) {
+        return (std::uint64_t(std::uint32_t(cx)) << 32) | std::uint32_t(cy);
+    }
+
+    void submit(int cx, int cy);
+    std::size_t acquireSlot();
+    // Upload c's instances that touch a visible cell into its slot
+    std::size_t fillSlot(Chunk& c,
+                         const std::function<void(std::size_t, const std::vector<glm::mat4>&)>& upload);
+
+    const Map&                                map;
+    ThreadPool&                               pool;
+    Settings                                  settings;
+    std::size_t                               slots;
+    int                                       chunksX, chunksY;
+    std::uint64_t                             frame = 0;
+    const OccupancyGrid*                      visibleCells = nullptr;
+    std::uint64_t                             visibility = 1;   // bumped by setVisibleCells
+    std::vector<glm::mat4>                    filtered;         // fillSlot scratch
+    std::unordered_map<std::uint64_t, Chunk>  chunks;
+    std::vector<std::size_t>                  freeSlots;
+    std::shared_ptr<Results>                  results;
+};
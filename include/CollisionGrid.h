@@ -1,40 +1,109 @@
 // include/CollisionGrid.h
 #pragma once
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
+#include "CollisionWorld.h"
+#include "Map.h"
+#include "WallRects.h"
+
+class ThreadPool;
+
 struct AABB {
     glm::vec3 center;
-    float halfSize;
+    glm::vec3 halfExtents;
     bool intersectsSphere(const glm::vec3& pos, float radius) const {
         glm::vec3 diff = glm::abs(pos - center);
-        return (diff.x <= halfSize + radius) &&
-               (diff.y <= halfSize + radius) &&
-               (diff.z <= halfSize + radius);
+        return (diff.x <= halfExtents.x + radius) &&
+               (diff.y <= halfExtents.y + radius) &&
+               (diff.z <= halfExtents.z + radius);
     }
 };
 
-class CollisionGrid {
+class CollisionGrid : public CollisionWorld {
 public:
-    // Build from wall centers (assumes unit cubes at Y=0)
-    void build(const std::vector<glm::vec3>& wallPositions, float wallHeight) {
-        aabbs.clear();
-        for (auto& wp : wallPositions) {
-            AABB box;
-            box.center = glm::vec3(wp.x, wallHeight * 0.5f, wp.z);
-            box.halfSize = std::max(0.5f, wallHeight * 0.5f);
-            aabbs.push_back(box);
-        }
-    }
+    enum class Mode {
+        Boxes,  // per-wall AABBs in a spatial hash
+        Tiles   // unit cells read straight from Map occupancy
+    };
 
-    // Check sphere against all precomputed AABBs
-    bool collides(const glm::vec3& pos, float radius) const {
-        for (auto& box : aabbs) {
-            if (box.intersectsSphere(pos, radius)) return true;
-        }
-        return false;
-    }
+    // Build from wall centers (assumes unit cubes at Y=0) and bucket them by tile
+    void build(const std::vector<glm::vec3>& wallPositions, float wallHeight);
+
+    // Build one box per merged wall rect (see mergeWallRects)
+    void build(const Map& map, const std::vector<WallRect>& rects, float wallHeight);
+
+    // Query the map's wall cells directly; nothing is stored per wall.
+    // The map must outlive the grid.
+    void build(const Map& map, float wallHeight);
+
+    // Check sphere against walls near pos
+    bool collides(const glm::vec3& pos, float radius) const override;
+
+    // Test many spheres in one pass: out[i] = collides(positions[i], radii[i]).
+    // radii may hold a single value shared by every sphere. Spheres go in
+    // SIMD groups: box mode tests each box around a group against all of
+    // it at once, tile mode (AVX2 builds) gathers the group's wall bits
+    // together. Groups spread over many tiles, and tile-mode radii of 1 or
+    // more, are tested one sphere at a time.
+    void collidesBatch(std::span<const glm::vec3> positions,
+                       std::span<const float> radii,
+                       std::span<std::uint8_t> out) const;
+
+    // Swept sphere over the tiles the motion covers
+    SweepHit sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const override;
+
+    // Walk the tiles along the ray (Amanatides-Woo DDA) and return the first
+    // wall hit within maxDist. Cost grows with distance, not wall count.
+    RayHit raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const override;
+
+    // Cast every ray, spreading the batch over the pool's workers
+    void raycastBatch(std::span<const Ray> rays, std::span<RayHit> out, ThreadPool& pool) const;
+
+    Mode getMode() const { return mode; }
 
 private:
-    std::vector<AABB> aabbs;
+    // Bucket boxes by tile and flatten them into the SoA store
+    void buildBoxes(const std::vector<AABB>& aabbs);
+    bool collidesBoxes(const glm::vec3& pos, float radius) const;
+    bool collidesTiles(const glm::vec3& pos, float radius) const;
+    // One SIMD group of collidesBatch: n spheres in lanes, the rest padding.
+    // Returns false, leaving out alone, when the group needs the one-by-one path.
+    bool collidesLanes(const float* px, const float* py, const float* pz, const float* r,
+                       float rMax, std::size_t n, std::span<std::uint8_t> out) const;
+    SweepHit sweepBoxes(const glm::vec3& start, const glm::vec3& delta, float radius) const;
+    SweepHit sweepTiles(const glm::vec3& start, const glm::vec3& delta, float radius) const;
+    // Nearest wall hit in tile (x, z) with distance <= tLimit
+    bool raycastTile(int x, int z, const glm::vec3& origin, const glm::vec3& dir,
+                     float tLimit, RayHit& hit) const;
+
+    // Pack integer tile coordinates (x, z) into one hash key
+    static std::uint64_t cellKey(int x, int z) {
+        return (std::uint64_t(std::uint32_t(x)) << 32) | std::uint32_t(z);
+    }
+
+    // Structure-of-arrays box store. Each tile's boxes are one contiguous run,
+    // padded to the SIMD lane count with boxes that can never be hit.
+    struct BoxSoA {
+        std::vector<float> cx, cy, cz;
+        std::vector<float> hx, hy, hz;
+    };
+    struct CellRange {
+        std::uint32_t begin = 0;
+        std::uint32_t count = 0;   // multiple of the SIMD lane count
+    };
+
+    BoxSoA boxes;
+    // Spatial hash: tile (x, z) -> run of every box whose XZ extent touches it
+    std::unordered_map<std::uint64_t, CellRange> cells;
+
+    Mode       mode       = Mode::Boxes;
+    const Map* map        = nullptr;
+    float      wallHeight = 0.0f;
+    // Vertical extent of all walls, bounds ray traversal
+    float      minY       = 0.0f;
+    float      maxY       = 0.0f;
 };
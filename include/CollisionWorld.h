@@ -0,0 +1,65 @@
+// include/CollisionWorld.h
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+// Result of a swept-sphere query
+struct SweepHit {
+    bool      hit    = false;
+    float     toi    = 1.0f;          // fraction of delta travelled before contact
+    glm::vec3 normal = glm::vec3(0);  // surface normal at contact
+};
+
+// One ray for batched casts
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 dir;
+    float     maxDist;
+};
+
+// Result of a ray cast
+struct RayHit {
+    bool       hit      = false;
+    float      distance = 0.0f;           // along the normalized direction
+    glm::vec3  point    = glm::vec3(0);
+    glm::vec3  normal   = glm::vec3(0);   // zero when the ray starts inside a wall
+    glm::ivec2 tile     = glm::ivec2(0);  // grid backends: world tile (x, z) of the hit
+};
+
+// Static collision geometry queried by movement, hitscan and AI code.
+// Implementations are read-only after build, so queries are thread-safe.
+class CollisionWorld {
+public:
+    virtual ~CollisionWorld() = default;
+
+    // Does a sphere at pos touch any geometry?
+    virtual bool collides(const glm::vec3& pos, float radius) const = 0;
+
+    // Move a sphere from start along delta and report the first contact.
+    // Geometry the sphere already overlaps at start is ignored so it can escape.
+    virtual SweepHit sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const = 0;
+
+    // First surface hit by the ray within maxDist
+    virtual RayHit raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const = 0;
+
+    // Move along delta, sliding along every surface hit, for up to
+    // maxIterations contacts. Returns the final position; never tunnels
+    // however long delta is.
+    glm::vec3 slide(const glm::vec3& start, const glm::vec3& delta, float radius,
+                    int maxIterations = 4) const;
+};
+
+// Several backends queried as one (e.g. the wall grid plus prop meshes).
+// Members are not owned and must outlive the set.
+class CollisionSet : public CollisionWorld {
+public:
+    void add(const CollisionWorld& world) { members.push_back(&world); }
+    void clear() { members.clear(); }
+
+    bool collides(const glm::vec3& pos, float radius) const override;
+    SweepHit sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const override;
+    RayHit raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const override;
+
+private:
+    std::vector<const CollisionWorld*> members;
+};
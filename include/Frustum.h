@@ -0,0 +1,29 @@
+// include/Frustum.h
+#pragma once
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix (Gribb & Hartmann), with
+// normals pointing inward, for quick box tests
+struct Frustum {
+    glm::vec4 planes[6];
+
+    explicit Frustum(const glm::mat4& viewProj) {
+        const glm::mat4 rows = glm::transpose(viewProj);
+        planes[0] = rows[3] + rows[0];   // left
+        planes[1] = rows[3] - rows[0];   // right
+        planes[2] = rows[3] + rows[1];   // bottom
+        planes[3] = rows[3] - rows[1];   // top
+        planes[4] = rows[3] + rows[2];   // near (GL clip space: z >= -w)
+        planes[5] = rows[3] - rows[2];   // far
+    }
+
+    // False only when [lo, hi] lies wholly behind one plane, so a box just
+    // off a frustum corner can still pass; it never rejects a visible box
+    bool intersectsBox(const glm::vec3& lo, const glm::vec3& hi) const {
+        for (const glm::vec4& p : planes) {
+            const glm::vec3 corner(p.x > 0 ? hi.x : lo.x, p.y > 0 ? hi.y : lo.y, p.z > 0 ? hi.z : lo.z);
+            if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0) return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,50 @@
+// include/MeshBVH.h
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CollisionWorld.h"
+
+// Triangle-level collision for arbitrary static meshes (props, OBJ level
+// pieces). Triangles go into a binned-SAH bounding volume hierarchy stored
+// as a flat depth-first node array.
+class MeshBVH : public CollisionWorld {
+public:
+    struct Triangle {
+        glm::vec3 v0, v1, v2;
+    };
+
+    // Queue a triangle soup (3 positions per triangle), e.g. from
+    // Mesh::loadTriangles, placed in the world by transform
+    void addMesh(const std::vector<glm::vec3>& soup, const glm::mat4& transform = glm::mat4(1.0f));
+
+    // Build the hierarchy over everything added so far
+    void build();
+
+    bool collides(const glm::vec3& pos, float radius) const override;
+    SweepHit sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const override;
+    RayHit raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const override;
+
+    std::size_t triangleCount() const { return tris.size(); }
+    std::size_t nodeCount() const { return nodes.size(); }
+
+private:
+    // 32 bytes: two nodes per cache line. Interior nodes keep their left
+    // child at index + 1 and store the right child; leaves store their
+    // first triangle.
+    struct Node {
+        glm::vec3     bmin;
+        std::uint32_t rightOrFirst;
+        glm::vec3     bmax;
+        std::uint32_t count;    // 0 for interior nodes
+    };
+    static_assert(sizeof(Node) == 32, "MeshBVH::Node should stay 32 bytes");
+
+    std::uint32_t buildNode(std::uint32_t first, std::uint32_t count,
+                            std::vector<glm::vec3>& centroids, std::uint32_t depth);
+
+    std::vector<Triangle> tris;
+    std::vector<Node>     nodes;
+};
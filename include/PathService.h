@@ -0,0 +1,108 @@
+// include/PathService.h
+#pragma once
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct Map;
+class FlowField;
+class ThreadPool;
+
+// Path requests answered off the frame loop. Agents submit (start, goal)
+// and get a ticket; tick() hands queued work to the worker pool each frame
+// and take() collects finished paths later. Nothing here blocks the
+// calling thread on a search.
+//
+// Each tick starts at most budgetMs of worker time, split over up to
+// maxJobs jobs. A job stops taking requests once its share is spent; one
+// query in progress always runs to the end. Requests sharing a goal are
+// searched together: coalesceAt or more of them get one flow field toward
+// the goal, built in slices across ticks, and every path is read off it.
+class PathService {
+public:
+    using Ticket = std::uint64_t;   // 0 is never issued
+    // Thread-safe point query: cells from start to goal, start first
+    using Solver = std::function<bool(glm::ivec2, glm::ivec2, std::vector<glm::ivec2>&)>;
+
+    enum class Status {
+        Pending,   // queued or being searched
+        Found,
+        NoPath,
+        Unknown    // never issued, cancelled or already taken
+    };
+
+    struct Settings {
+        double      budgetMs      = 2.0;       // worker time started per tick
+        unsigned    maxJobs       = 0;         // jobs in flight; 0 = one per worker
+        std::size_t coalesceAt    = 8;         // same-goal requests that share a flow field
+        std::size_t fieldSlice    = 1 << 14;   // flow field cells between clock checks
+    };
+
+    // map must outlive the service and not change while requests are in
+    // flight; solve must be safe to call from several workers at once
+    PathService(const Map& map, ThreadPool& pool, Solver solve, const Settings& settings);
+    ~PathService();   // drops queued requests and waits for running jobs
+
+    PathService(const PathService&) = delete;
+    PathService& operator=(const PathService&) = delete;
+
+    Ticket request(glm::ivec2 start, glm::ivec2 goal);
+
+    // Forget a request; a search already running for it is discarded
+    void cancel(Ticket ticket);
+
+    // Once per frame: start worker jobs for queued requests within the budget
+    void tick();
+
+    // Status of a request. Found and NoPath hand over the result (path
+    // cells, start first) and forget the ticket.
+    Status take(Ticket ticket, std::vector<glm::ivec2>& path);
+
+    std::size_t pendingCount() const;
+
+private:
+    struct Entry {
+        Status                  status = Status::Pending;
+        glm::ivec2              start;
+        std::vector<glm::ivec2> path;
+    };
+
+    // Requests for one goal, waiting or being worked on
+    struct Group {
+        glm::ivec2                 goal;
+        std::vector<Ticket>        tickets;
+        std::unique_ptr<FlowField> field;   // coalesced groups, built across ticks
+    };
+
+    // Shared with the jobs so they never touch the service itself
+    struct State {
+        mutable std::mutex                                  mutex;
+        std::condition_variable                             idle;
+        std::deque<std::unique_ptr<Group>>                  queue;
+        std::unordered_map<std::uint64_t, Group*>           waiting;   // by goal, not yet taken
+        std::unordered_map<Ticket, Entry>                   entries;
+        int                                                 inFlight = 0;
+        bool                                                stopping = false;
+    };
+
+    static std::uint64_t goalKey(glm::ivec2 g) {
+        return (std::uint64_t(std::uint32_t(g.x)) << 32) | std::uint32_t(g.y);
+    }
+
+    static void runJob(const std::shared_ptr<State>& state, const Map& map, const Solver& solve,
+                       const Settings& settings, double budgetMs);
+
+    const Map&             map;
+    ThreadPool&            pool;
+    Solver                 solve;
+    Settings               settings;
+    Ticket                 nextTicket = 1;
+    std::shared_ptr<State> state;
+};
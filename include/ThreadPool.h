@@ -0,0 +1,41 @@
+// include/ThreadPool.h
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from one FIFO job queue.
+class ThreadPool {
+public:
+    // threadCount == 0 picks one worker per hardware thread, minus the caller
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of worker threads (the calling thread is not counted)
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    // Queue a job to run on some worker
+    void submit(std::function<void()> job);
+
+    // Split [0, count) into chunks of at most grain items and run
+    // body(begin, end) for each on the workers and the calling thread.
+    // Blocks until every chunk is done. body must not throw.
+    void parallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& body);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex                        mutex;
+    std::condition_variable           wake;
+    bool                              stopping = false;
+};
@@ -0,0 +1,177 @@
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float kFar = 1e20f;
+
+// 1D squared distance transform of f (Felzenszwalb & Huttenlocher 2012).
+// f holds 0 at features and kFar elsewhere; d receives the result.
+// v and z are scratch buffers of at least n and n + 1 entries.
+void edt1d(const float* f, float* d, int n, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -kFar;
+    z[1] = kFar;
+    for (int q = 1; q < n; ++q) {
+        float s;
+        for (;;) {
+            int p = v[k];
+            s = ((f[q] + float(q) * q) - (f[p] + float(p) * p)) / (2.0f * (q - p));
+            if (s > z[k] || k == 0) break;
+            --k;
+        }
+        if (s <= z[k]) {   // k == 0 and the new parabola dominates everywhere
+            v[0] = q;
+            z[1] = kFar;
+            continue;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = kFar;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        float dq = float(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// 2D squared EDT in place over a w x h row-major image
+void edt2d(std::vector<float>& img, int w, int h) {
+    int n = std::max(w, h);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < h; ++y) f[y] = img[std::size_t(y) * w + x];
+        edt1d(f.data(), d.data(), h, v.data(), z.data());
+        for (int y = 0; y < h; ++y) img[std::size_t(y) * w + x] = d[y];
+    }
+    for (int y = 0; y < h; ++y) {
+        float* row = &img[std::size_t(y) * w];
+        std::copy(row, row + w, f.begin());
+        edt1d(f.data(), row, w, v.data(), z.data());
+    }
+}
+
+} // namespace
+
+void DistanceField::build(const Map& map, int samplesPerCell, float maxDistance) {
+    perCell  = std::max(1, samplesPerCell);
+    maxDist  = maxDistance;
+    samplesX = map.width() * perCell;
+    samplesZ = map.height() * perCell;
+    dist.assign(std::size_t(samplesX) * samplesZ, maxDist);
+    compute(map, 0, 0, samplesX, samplesZ, 0, 0, samplesX, samplesZ);
+}
+
+void DistanceField::updateCell(const Map& map, int x, int y) {
+    if (dist.empty()) return;
+    // Samples covering the cell in world XZ
+    int cx0 = x * perCell;
+    int cz0 = (map.height() - 1 - y) * perCell;
+    int reach = (int)std::ceil(maxDist * perCell) + 1;
+
+    // Distances are clamped, so a sample only depends on features within
+    // reach of it: recompute the window from a region one reach wider
+    int wx0 = std::max(0, cx0 - reach), wx1 = std::min(samplesX, cx0 + perCell + reach);
+    int wz0 = std::max(0, cz0 - reach), wz1 = std::min(samplesZ, cz0 + perCell + reach);
+    int x0 = std::max(0, wx0 - reach), x1 = std::min(samplesX, wx1 + reach);
+    int z0 = std::max(0, wz0 - reach), z1 = std::min(samplesZ, wz1 + reach);
+    compute(map, x0, z0, x1, z1, wx0, wz0, wx1, wz1);
+}
+
+void DistanceField::compute(const Map& map, int x0, int z0, int x1, int z1,
+                            int wx0, int wz0, int wx1, int wz1) {
+    const int w = x1 - x0, h = z1 - z0;
+    const int rows = map.height();
+    std::vector<unsigned char> wall(std::size_t(w) * h);
+    for (int j = 0; j < h; ++j) {
+        int cellZ = (z0 + j) / perCell;
+        for (int i = 0; i < w; ++i)
+            wall[std::size_t(j) * w + i] = map.isWall((x0 + i) / perCell, rows - 1 - cellZ);
+    }
+
+    // Distance from each free sample to the nearest wall sample, and from
+    // each wall sample to the nearest free one
+    std::vector<float> toWall(wall.size()), toFree(wall.size());
+    for (std::size_t k = 0; k < wall.size(); ++k) {
+        toWall[k] = wall[k] ? 0.0f : kFar;
+        toFree[k] = wall[k] ? kFar : 0.0f;
+    }
+    edt2d(toWall, w, h);
+    edt2d(toFree, w, h);
+
+    // The surface lies half a sample beyond the nearest opposite sample
+    const float spacing = 1.0f / perCell;
+    for (int j = wz0; j < wz1; ++j) {
+        for (int i = wx0; i < wx1; ++i) {
+            std::size_t k = std::size_t(j - z0) * w + (i - x0);
+            float d = wall[k] ? -(std::sqrt(toFree[k]) - 0.5f) * spacing
+                              :  (std::sqrt(toWall[k]) - 0.5f) * spacing;
+            dist[std::size_t(j) * samplesX + i] = std::clamp(d, -maxDist, maxDist);
+        }
+    }
+}
+
+float DistanceField::at(int i, int j) const {
+    i = std::clamp(i, 0, samplesX - 1);
+    j = std::clamp(j, 0, samplesZ - 1);
+    return dist[std::size_t(j) * samplesX + i];
+}
+
+float DistanceField::sample(const glm::vec3& worldPos) const {
+    if (dist.empty()) return maxDist;
+    float u = worldPos.x * perCell - 0.5f;
+    float v = worldPos.z * perCell - 0.5f;
+    int i = (int)std::floor(u), j = (int)std::floor(v);
+    float fu = u - i, fv = v - j;
+    float a = at(i, j)     + (at(i + 1, j)     - at(i, j))     * fu;
+    float b = at(i, j + 1) + (at(i + 1, j + 1) - at(i, j + 1)) * fu;
+    return a + (b - a) * fv;
+}
+
+glm::vec3 DistanceField::gradient(const glm::vec3& worldPos) const {
+    float h = 0.5f / perCell;
+    float gx = sample(worldPos + glm::vec3(h, 0, 0)) - sample(worldPos - glm::vec3(h, 0, 0));
+    float gz = sample(worldPos + glm::vec3(0, 0, h)) - sample(worldPos - glm::vec3(0, 0, h));
+    float len = std::sqrt(gx * gx + gz * gz);
+    return len > 1e-6f ? glm::vec3(gx / len, 0.0f, gz / len) : glm::vec3(0);
+}
+
+bool DistanceField::isClear(const glm::vec3& pos, float radius) const {
+    // A box within radius on every axis can be up to radius * sqrt(2) away
+    // in XZ; 1.5 samples covers the surface and interpolation error
+    const float error = 1.5f / perCell;
+    return sample(pos) - error > radius * 1.41421356f;
+}
+
+glm::vec3 DistanceField::resolve(const glm::vec3& pos, float radius) const {
+    glm::vec3 p = pos;
+    for (int i = 0; i < 4; ++i) {
+        float d = sample(p);
+        if (d >= radius) break;
+        glm::vec3 g = gradient(p);
+        if (g == glm::vec3(0)) break;
+        p += g * (radius - d);
+    }
+    return p;
+}
+
+glm::vec3 DistanceField::steer(const glm::vec3& pos, const glm::vec3& desired,
+                               float radius, float influence) const {
+    float d = sample(pos);
+    if (d >= influence || influence <= radius) return desired;
+    glm::vec3 g = gradient(pos);
+    float w = 1.0f - std::clamp((d - radius) / (influence - radius), 0.0f, 1.0f);
+
+    glm::vec3 v = desired;
+    float into = glm::dot(v, g);
+    if (into < 0.0f) v -= g * (into * w);
+    return v + g * (w * glm::length(desired) * 0.5f);
+}
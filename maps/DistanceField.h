@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+// Signed distance to the nearest wall surface, sampled on a regular grid
+// over the map's XZ plane: positive in free space, negative inside walls,
+// clamped to +-maxDistance. Built with a separable linear-time Euclidean
+// distance transform (Felzenszwalb & Huttenlocher) and sampled bilinearly.
+class DistanceField {
+public:
+    // samplesPerCell controls resolution (memory grows with its square)
+    void build(const Map& map, int samplesPerCell = 2, float maxDistance = 8.0f);
+
+    // Refresh the samples a changed cell can affect (call after Map::setWall)
+    void updateCell(const Map& map, int x, int y);
+
+    // Distance from world XZ to the nearest wall surface; y is ignored
+    float sample(const glm::vec3& worldPos) const;
+
+    // Unit XZ direction of steepest increase, i.e. away from the nearest wall
+    glm::vec3 gradient(const glm::vec3& worldPos) const;
+
+    // True when no wall cell lies within radius of pos on any axis, so a
+    // sphere there cannot hit even the per-axis box test of CollisionGrid.
+    // Allows for the sampling error, so it may say false near the limit.
+    bool isClear(const glm::vec3& pos, float radius) const;
+
+    // Push a sphere out of walls along the gradient
+    glm::vec3 resolve(const glm::vec3& pos, float radius) const;
+
+    // Bend a desired velocity away from walls closer than influence:
+    // the into-wall part fades out and a push along the gradient fades in
+    glm::vec3 steer(const glm::vec3& pos, const glm::vec3& desired,
+                    float radius, float influence) const;
+
+    bool empty() const { return dist.empty(); }
+
+private:
+    // Run the signed EDT over samples [x0, x1) x [z0, z1) and store
+    // distances for the window [wx0, wx1) x [wz0, wz1) inside it
+    void compute(const Map& map, int x0, int z0, int x1, int z1,
+                 int wx0, int wz0, int wx1, int wz1);
+    float at(int i, int j) const;
+
+    std::vector<float> dist;   // row-major over (world z, world x) samples
+    int   samplesX = 0, samplesZ = 0;
+    int   perCell = 1;
+    float maxDist = 0.0f;
+};
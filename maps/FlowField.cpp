@@ -0,0 +1,127 @@
+#include "FlowField.h"
+
+#include <algorithm>
+
+namespace {
+
+// Neighbour offsets in map cells; straight steps first
+constexpr int kDX[8]   = { 1, -1, 0, 0, 1, -1, 1, -1 };
+constexpr int kDY[8]   = { 0, 0, 1, -1, 1, 1, -1, -1 };
+constexpr std::uint32_t kStepCost[8] = { 2, 2, 2, 2, 3, 3, 3, 3 };
+
+// Neighbour k of a cell is reached by stepping back along offset k, so the
+// step stored for it is the opposite offset
+constexpr std::uint8_t kOpposite[8] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+
+glm::vec3 stepDir(int k) {
+    // Map y grows toward world -z
+    return glm::normalize(glm::vec3((float)kDX[k], 0.0f, (float)-kDY[k]));
+}
+
+} // namespace
+
+const std::array<glm::vec3, 9> FlowField::kStepDir = {
+    stepDir(0), stepDir(1), stepDir(2), stepDir(3),
+    stepDir(4), stepDir(5), stepDir(6), stepDir(7), glm::vec3(0.0f)
+};
+
+const std::array<glm::ivec2, 9> FlowField::kStepCell = {
+    glm::ivec2(kDX[0], kDY[0]), glm::ivec2(kDX[1], kDY[1]), glm::ivec2(kDX[2], kDY[2]),
+    glm::ivec2(kDX[3], kDY[3]), glm::ivec2(kDX[4], kDY[4]), glm::ivec2(kDX[5], kDY[5]),
+    glm::ivec2(kDX[6], kDY[6]), glm::ivec2(kDX[7], kDY[7]), glm::ivec2(0)
+};
+
+void FlowField::build(const Map& map, glm::ivec2 goal) {
+    reset(map);
+    setGoal(map, goal);
+    while (searching) advance(map, std::size_t(w) * h + 1);
+}
+
+void FlowField::reset(const Map& map) {
+    w = map.width();
+    h = map.height();
+    const std::size_t cells = std::size_t(w) * h;
+    for (Field* f : { &live, &back }) {
+        f->cost.assign(cells, kUnreached);
+        f->step.assign(cells, kNoStep);
+        f->stamp.assign(cells, 0);
+        f->generation = 1;
+    }
+    liveGoal = nextGoal = {-1, -1};
+    searching = false;
+}
+
+void FlowField::setGoal(const Map& map, glm::ivec2 goal) {
+    nextGoal = goal;
+    if (!searching && goal != liveGoal) startSearch(map, goal);
+}
+
+void FlowField::startSearch(const Map& map, glm::ivec2 goal) {
+    // A new generation leaves every cell unreached; only a wrap of the
+    // stamp, once per 65535 searches, clears them for real
+    if (++back.generation == 0) {
+        std::fill(back.stamp.begin(), back.stamp.end(), std::uint16_t(0));
+        back.generation = 1;
+    }
+    for (auto& b : buckets) b.clear();
+    open = 0;
+    current = 0;
+    backGoal = goal;
+    searching = true;
+
+    if ((unsigned)goal.x < (unsigned)w && (unsigned)goal.y < (unsigned)h && !map.isWall(goal.x, goal.y)) {
+        const std::uint32_t g = std::uint32_t(std::size_t(goal.y) * w + goal.x);
+        back.cost[g]  = 0;
+        back.step[g]  = kNoStep;
+        back.stamp[g] = back.generation;
+        buckets[0].push_back(g);
+        open = 1;
+    }
+}
+
+bool FlowField::advance(const Map& map, std::size_t maxCells) {
+    if (!searching) {
+        if (nextGoal == liveGoal) return false;
+        startSearch(map, nextGoal);
+    }
+    auto backCost = [&](std::uint32_t c) {
+        return back.stamp[c] == back.generation ? back.cost[c] : kUnreached;
+    };
+
+    for (std::size_t settled = 0; open > 0 && settled < maxCells; ) {
+        auto& bucket = buckets[current & 3];
+        if (bucket.empty()) {
+            ++current;
+            continue;
+        }
+        const std::uint32_t c = bucket.back();
+        bucket.pop_back();
+        --open;
+        if (backCost(c) != current) continue;   // superseded by a cheaper entry
+        ++settled;
+
+        const int x = int(c % std::uint32_t(w)), y = int(c / std::uint32_t(w));
+        for (int k = 0; k < 8; ++k) {
+            const int nx = x + kDX[k], ny = y + kDY[k];
+            if ((unsigned)nx >= (unsigned)w || (unsigned)ny >= (unsigned)h || map.isWall(nx, ny))
+                continue;
+            // No corner cutting: a diagonal needs both straight cells open
+            if (k >= 4 && (map.isWall(nx, y) || map.isWall(x, ny))) continue;
+
+            const std::uint32_t n = std::uint32_t(std::size_t(ny) * w + nx);
+            const std::uint32_t cost = current + kStepCost[k];
+            if (cost >= backCost(n)) continue;
+            back.cost[n]  = cost;
+            back.step[n]  = kOpposite[k];
+            back.stamp[n] = back.generation;
+            buckets[cost & 3].push_back(n);
+            ++open;
+        }
+    }
+    if (open > 0) return false;
+
+    std::swap(live, back);
+    liveGoal = backGoal;
+    searching = false;
+    return true;
+}
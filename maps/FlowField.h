@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+// Shortest-path field toward one goal cell (the player) for any number of
+// agents: each cell stores its path cost and the step to take, so steering
+// is one lookup per agent whatever the crowd size.
+//
+// Costs come from a bucket-queue Dijkstra over the 8-connected grid with
+// integer weights 2 (straight) and 3 (diagonal, an octile approximation);
+// diagonals never cut a wall corner. A new goal is searched into a back
+// buffer a budget of cells at a time, so agents keep following the old
+// field until the new one is complete. A goal that moves mid-search does
+// not restart it: the search finishes, goes live, and the latest goal is
+// searched next, so the field keeps going live however often the goal
+// moves. Cells carry a generation stamp instead of being cleared, so
+// starting a search costs nothing per cell.
+class FlowField {
+public:
+    static constexpr std::uint32_t kUnreached = ~std::uint32_t(0);
+
+    // Size the field for map and compute it toward goal in one go
+    void build(const Map& map, glm::ivec2 goal);
+
+    // Size the field for map with no goal: every cell kUnreached until a
+    // setGoal() search completes
+    void reset(const Map& map);
+
+    // Search toward a new goal cell: at once if no search is pending,
+    // otherwise once the pending one completes. Ignored if it is already
+    // the live goal.
+    void setGoal(const Map& map, glm::ivec2 goal);
+
+    // Settle up to maxCells cells of the pending search; returns true when
+    // that finishes it and the new field goes live (a search toward a goal
+    // set meanwhile starts on the next call)
+    bool advance(const Map& map, std::size_t maxCells);
+
+    bool pending() const { return searching; }
+    glm::ivec2 goal() const { return liveGoal; }
+
+    // Path cost to the goal (2 per straight step, 3 per diagonal), or
+    // kUnreached for walls and cells cut off from the goal
+    std::uint32_t cost(int x, int y) const {
+        if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return kUnreached;
+        const std::size_t i = std::size_t(y) * w + x;
+        return live.stamp[i] == live.generation ? live.cost[i] : kUnreached;
+    }
+
+    // Unit world XZ direction of the next step toward the goal; zero at the
+    // goal itself and wherever cost() is kUnreached
+    glm::vec3 direction(int x, int y) const {
+        if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return glm::vec3(0.0f);
+        return kStepDir[liveStep(std::size_t(y) * w + x)];
+    }
+    glm::vec3 direction(const Map& map, const glm::vec3& worldPos) const {
+        glm::ivec2 c = map.worldToCell(worldPos);
+        return direction(c.x, c.y);
+    }
+
+    // Cell the step from (x, y) leads to; (x, y) itself where there is no step.
+    // Steering at its centre rather than along direction() keeps agents
+    // that drifted off-centre from catching on wall corners.
+    glm::ivec2 nextCell(int x, int y) const {
+        if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return {x, y};
+        return glm::ivec2(x, y) + kStepCell[liveStep(std::size_t(y) * w + x)];
+    }
+
+    bool empty() const { return live.cost.empty(); }
+
+private:
+    static constexpr std::uint8_t kNoStep = 8;
+    static const std::array<glm::vec3, 9>  kStepDir;    // per step code, world XZ
+    static const std::array<glm::ivec2, 9> kStepCell;   // per step code, map cells
+
+    // cost and step of a cell hold only where its stamp is the field's
+    // generation; elsewhere the cell is unreached
+    struct Field {
+        std::vector<std::uint32_t> cost;
+        std::vector<std::uint8_t>  step;   // 0-7: neighbour to move to, kNoStep: none
+        std::vector<std::uint16_t> stamp;
+        std::uint16_t              generation = 1;
+    };
+
+    std::uint8_t liveStep(std::size_t i) const {
+        return live.stamp[i] == live.generation ? live.step[i] : kNoStep;
+    }
+
+    void startSearch(const Map& map, glm::ivec2 goal);
+
+    Field         live, back;
+    glm::ivec2    liveGoal{-1, -1}, backGoal{-1, -1};
+    glm::ivec2    nextGoal{-1, -1};   // latest setGoal(), searched once the pending one ends
+    bool          searching = false;
+    int           w = 0, h = 0;
+
+    // Dial's algorithm: edge weights are at most 3, so four rotating
+    // buckets hold every open cell. Entries whose cost has since dropped
+    // are skipped when popped.
+    std::array<std::vector<std::uint32_t>, 4> buckets;
+    std::uint32_t current = 0;   // cost of the bucket being drained
+    std::size_t   open = 0;      // entries across all buckets
+};
@@ -0,0 +1,582 @@
+#include "HierarchicalPathfinder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+
+namespace {
+
+// Same neighbourhood and weights as FlowField: straight steps first
+constexpr int kDX[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+constexpr int kDY[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+constexpr std::uint32_t kStepCost[8]  = { 2, 2, 2, 2, 3, 3, 3, 3 };
+constexpr std::uint8_t  kOpposite[8]  = { 1, 0, 3, 2, 7, 6, 5, 4 };
+constexpr std::uint8_t  kNoStep = 8;
+constexpr std::uint32_t kUnreached = HierarchicalPathfinder::kUnreached;
+constexpr std::uint32_t kNoNode = ~std::uint32_t(0);
+
+// Level-0 border stretches shorter than this get one entrance in the
+// middle, longer ones an entrance at each end
+constexpr int kSplitEntranceLength = 6;
+// Cluster side ratio between consecutive levels
+constexpr int kLevelRatio = 4;
+
+std::uint32_t octile(glm::ivec2 a, glm::ivec2 b) {
+    const int dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+    return std::uint32_t(3 * std::min(dx, dy) + 2 * std::abs(dx - dy));
+}
+
+bool canStep(const Map& map, glm::ivec2 c, int k) {
+    const int nx = c.x + kDX[k], ny = c.y + kDY[k];
+    if (nx < 0 || ny < 0 || nx >= map.width() || ny >= map.height() || map.isWall(nx, ny)) return false;
+    return k < 4 || (!map.isWall(nx, c.y) && !map.isWall(c.x, ny));
+}
+
+// Cells of one level-0 cluster with the legal moves out of each precomputed,
+// so the per-entrance searches don't go back to the map
+struct LocalGrid {
+    int x0 = 0, y0 = 0, width = 0, height = 0;
+    std::vector<std::uint8_t> moves;   // bit k: step k stays inside and is legal
+
+    void load(const Map& map, int rx0, int ry0, int rx1, int ry1) {
+        x0 = rx0; y0 = ry0; width = rx1 - rx0; height = ry1 - ry0;
+        moves.assign(std::size_t(width) * height, 0);
+        for (int y = ry0; y < ry1; ++y) {
+            for (int x = rx0; x < rx1; ++x) {
+                if (map.isWall(x, y)) continue;
+                std::uint8_t m = 0;
+                for (int k = 0; k < 8; ++k) {
+                    const int nx = x + kDX[k], ny = y + kDY[k];
+                    if (nx >= rx0 && nx < rx1 && ny >= ry0 && ny < ry1 && canStep(map, {x, y}, k))
+                        m |= std::uint8_t(1u << k);
+                }
+                moves[index({x, y})] = m;
+            }
+        }
+    }
+    bool contains(glm::ivec2 c) const {
+        return c.x >= x0 && c.x < x0 + width && c.y >= y0 && c.y < y0 + height;
+    }
+    std::size_t index(glm::ivec2 c) const { return std::size_t(c.y - y0) * width + (c.x - x0); }
+};
+
+// Per-thread search state, so const queries can run concurrently
+struct GraphScratch {
+    std::vector<std::uint32_t> g, parent, stamp, closed, targetCost, targetStamp;
+    std::uint32_t              generation = 0;
+    // (f, ~g) packed so that among equal f the deeper node pops first
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> heap;
+};
+struct Scratch {
+    std::array<std::vector<std::uint32_t>, 4> buckets;
+    LocalGrid                  grid;
+    std::vector<std::uint32_t> dist;
+    std::vector<std::uint8_t>  step;
+    std::vector<GraphScratch>  levels;
+};
+thread_local Scratch scratch;
+
+// Dijkstra from source over the local grid (a cluster is a few hundred
+// cells, so every cell is settled). step, if given, holds for each cell the
+// move toward source.
+void gridDijkstra(const LocalGrid& grid, glm::ivec2 source,
+                  std::vector<std::uint32_t>& dist, std::vector<std::uint8_t>* step) {
+    dist.assign(grid.moves.size(), kUnreached);
+    if (step) step->assign(grid.moves.size(), kNoStep);
+    for (auto& b : scratch.buckets) b.clear();
+
+    const std::uint32_t s = std::uint32_t(grid.index(source));
+    dist[s] = 0;
+    scratch.buckets[0].push_back(s);
+    std::size_t open = 1;
+    for (std::uint32_t current = 0; open > 0; ) {
+        auto& bucket = scratch.buckets[current & 3];
+        if (bucket.empty()) { ++current; continue; }
+        const std::uint32_t i = bucket.back();
+        bucket.pop_back();
+        --open;
+        if (dist[i] != current) continue;
+
+        const int x = int(i % grid.width), y = int(i / grid.width);
+        for (unsigned m = grid.moves[i]; m; m &= m - 1) {
+            const int k = std::countr_zero(m);
+            const std::uint32_t j = std::uint32_t((y + kDY[k]) * grid.width + x + kDX[k]);
+            const std::uint32_t d = current + kStepCost[k];
+            if (d >= dist[j]) continue;
+            dist[j] = d;
+            if (step) (*step)[j] = kOpposite[k];
+            scratch.buckets[d & 3].push_back(j);
+            ++open;
+        }
+    }
+}
+
+} // namespace
+
+HierarchicalPathfinder::Rect HierarchicalPathfinder::clusterRect(int level, std::uint32_t cluster) const {
+    const Level& L = levels[level];
+    const int cx = int(cluster) % L.clustersX, cy = int(cluster) / L.clustersX;
+    return { cx * L.size, cy * L.size, std::min((cx + 1) * L.size, w), std::min((cy + 1) * L.size, h) };
+}
+
+std::uint32_t HierarchicalPathfinder::newNode(int level, glm::ivec2 cell, std::uint32_t border,
+                                              std::uint32_t lower) {
+    Level& L = levels[level];
+    std::uint32_t id;
+    if (!L.freeNodes.empty()) {
+        id = L.freeNodes.back();
+        L.freeNodes.pop_back();
+    } else {
+        id = std::uint32_t(L.nodes.size());
+        L.nodes.emplace_back();
+    }
+    Node& n = L.nodes[id];
+    n.cell    = cell;
+    n.cluster = L.clusterOf(cell);
+    n.border  = border;
+    n.lower   = lower;
+    n.upper   = kNone;
+    n.edges.clear();
+    L.clusterNodes[n.cluster].push_back(id);
+    if (level > 0) levels[level - 1].nodes[lower].upper = id;
+    return id;
+}
+
+void HierarchicalPathfinder::addEntrances(const Map& map, std::uint32_t border) {
+    Level& L = levels[0];
+    const int c  = int(border / 2);
+    const int cx = c % L.clustersX, cy = c / L.clustersX;
+    const bool east = (border & 1) == 0;
+    if (east ? cx + 1 >= L.clustersX : cy + 1 >= L.clustersY) return;
+
+    // Walk along the border; inside() is this cluster's edge, outside() the
+    // neighbour's
+    const int size = L.size;
+    const int length = east ? std::min(size, h - cy * size) : std::min(size, w - cx * size);
+    auto inside = [&](int i) {
+        return east ? glm::ivec2((cx + 1) * size - 1, cy * size + i)
+                    : glm::ivec2(cx * size + i, (cy + 1) * size - 1);
+    };
+    auto outside = [&](int i) { return inside(i) + (east ? glm::ivec2(1, 0) : glm::ivec2(0, 1)); };
+    auto open = [&](int i) {
+        glm::ivec2 a = inside(i), b = outside(i);
+        return !map.isWall(a.x, a.y) && !map.isWall(b.x, b.y);
+    };
+    auto link = [&](int i) {
+        std::uint32_t a = newNode(0, inside(i), border, kNone);
+        std::uint32_t b = newNode(0, outside(i), border, kNone);
+        L.nodes[a].edges.push_back({ b, kStepCost[0], true });
+        L.nodes[b].edges.push_back({ a, kStepCost[0], true });
+    };
+
+    for (int i = 0; i < length; ) {
+        if (!open(i)) { ++i; continue; }
+        int end = i;
+        while (end < length && open(end)) ++end;
+        if (end - i < kSplitEntranceLength) {
+            link((i + end - 1) / 2);
+        } else {
+            link(i);
+            link(end - 1);
+        }
+        i = end;
+    }
+}
+
+void HierarchicalPathfinder::promoteBorder(int level, std::uint32_t border) {
+    Level& L = levels[level];
+    Level& lo = levels[level - 1];
+    const int c  = int(border / 2);
+    const int cx = c % L.clustersX, cy = c / L.clustersX;
+    const bool east = (border & 1) == 0;
+    if (east ? cx + 1 >= L.clustersX : cy + 1 >= L.clustersY) return;
+    const std::uint32_t across = std::uint32_t(east ? c + 1 : c + L.clustersX);
+
+    auto joined = [&](std::uint32_t a, std::uint32_t b) {
+        for (const Edge& e : lo.nodes[a].edges)
+            if (e.to == b && !e.inter) return true;
+        return a == b;
+    };
+
+    // Each lower cluster along our side of the border owns one segment of
+    // it. Promote an entrance unless one already promoted from the same
+    // segment reaches it on both sides.
+    const int first = east ? cy * kLevelRatio : cx * kLevelRatio;
+    const int last  = std::min(first + kLevelRatio, east ? lo.clustersY : lo.clustersX);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> kept;
+    for (int i = first; i < last; ++i) {
+        const int lc = east ? i * lo.clustersX + (cx + 1) * kLevelRatio - 1
+                            : ((cy + 1) * kLevelRatio - 1) * lo.clustersX + i;
+        kept.clear();
+        for (std::uint32_t a : lo.clusterNodes[lc]) {
+            const Edge* cross = nullptr;
+            for (const Edge& e : lo.nodes[a].edges)
+                if (e.inter) cross = &e;
+            if (!cross || L.clusterOf(lo.nodes[cross->to].cell) != across) continue;
+            const std::uint32_t b = cross->to;
+            bool redundant = false;
+            for (auto& [ka, kb] : kept)
+                if (joined(a, ka) && joined(b, kb)) { redundant = true; break; }
+            if (redundant) continue;
+            kept.push_back({ a, b });
+
+            const std::uint32_t cost = cross->cost;
+            std::uint32_t ua = newNode(level, lo.nodes[a].cell, border, a);
+            std::uint32_t ub = newNode(level, lo.nodes[b].cell, border, b);
+            L.nodes[ua].edges.push_back({ ub, cost, true });
+            L.nodes[ub].edges.push_back({ ua, cost, true });
+        }
+    }
+}
+
+void HierarchicalPathfinder::removeBorderNodes(int level, std::uint32_t border) {
+    Level& L = levels[level];
+    const int c = int(border / 2);
+    const int other = (border & 1) == 0 ? c + 1 : c + L.clustersX;
+    for (int cluster : { c, other }) {
+        if (cluster >= L.clustersX * L.clustersY) continue;
+        auto& list = L.clusterNodes[cluster];
+        list.erase(std::remove_if(list.begin(), list.end(), [&](std::uint32_t id) {
+            Node& n = L.nodes[id];
+            if (n.border != border) return false;
+            if (level > 0 && levels[level - 1].nodes[n.lower].upper == id)
+                levels[level - 1].nodes[n.lower].upper = kNone;
+            n.edges.clear();
+            L.freeNodes.push_back(id);
+            return true;
+        }), list.end());
+    }
+}
+
+void HierarchicalPathfinder::linkCluster(const Map& map, int level, std::uint32_t cluster) {
+    Level& L = levels[level];
+    const Rect r = clusterRect(level, cluster);
+    const auto& list = L.clusterNodes[cluster];
+    if (level == 0) scratch.grid.load(map, r.x0, r.y0, r.x1, r.y1);
+
+    Costs seed(1);
+    for (std::uint32_t id : list) {
+        Node& n = L.nodes[id];
+        n.edges.erase(std::remove_if(n.edges.begin(), n.edges.end(),
+                                     [](const Edge& e) { return !e.inter; }),
+                      n.edges.end());
+        if (level == 0) {
+            gridDijkstra(scratch.grid, n.cell, scratch.dist, nullptr);
+        } else {
+            seed[0] = { n.lower, 0 };
+            search(level - 1, r, seed, nullptr, {}, nullptr);
+        }
+        const GraphScratch* gs = level > 0 ? &scratch.levels[level - 1] : nullptr;
+        for (std::uint32_t other : list) {
+            if (other == id) continue;
+            std::uint32_t d;
+            if (level == 0) {
+                d = scratch.dist[scratch.grid.index(L.nodes[other].cell)];
+            } else {
+                const std::uint32_t lo = L.nodes[other].lower;
+                d = gs->stamp[lo] == gs->generation ? gs->g[lo] : kUnreached;
+            }
+            if (d != kUnreached) n.edges.push_back({ other, d, false });
+        }
+    }
+}
+
+void HierarchicalPathfinder::build(const Map& map, int clusterSize, ThreadPool* pool) {
+    w = map.width();
+    h = map.height();
+    levels.clear();
+
+    auto addLevel = [&](int size) {
+        Level L;
+        L.size = size;
+        L.clustersX = std::max((w + size - 1) / size, 1);
+        L.clustersY = std::max((h + size - 1) / size, 1);
+        L.clusterNodes.assign(std::size_t(L.clustersX) * L.clustersY, {});
+        levels.push_back(std::move(L));
+    };
+    auto linkAll = [&](int level) {
+        // Clusters only touch their own nodes' edge lists, so they link in parallel
+        const std::size_t clusters = levels[level].clusterNodes.size();
+        auto linkRange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c < end; ++c) linkCluster(map, level, std::uint32_t(c));
+        };
+        if (pool) pool->parallelFor(clusters, 16, linkRange);
+        else      linkRange(0, clusters);
+    };
+
+    addLevel(std::max(clusterSize, 2));
+    for (std::uint32_t c = 0; c < levels[0].clusterNodes.size(); ++c) {
+        addEntrances(map, 2 * c);
+        addEntrances(map, 2 * c + 1);
+    }
+    linkAll(0);
+
+    while (std::max(levels.back().clustersX, levels.back().clustersY) > kLevelRatio) {
+        const int level = (int)levels.size();
+        addLevel(levels.back().size * kLevelRatio);
+        for (std::uint32_t c = 0; c < levels[level].clusterNodes.size(); ++c) {
+            promoteBorder(level, 2 * c);
+            promoteBorder(level, 2 * c + 1);
+        }
+        linkAll(level);
+    }
+}
+
+void HierarchicalPathfinder::updateCell(const Map& map, int x, int y) {
+    if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return;
+
+    auto addUnique = [](std::vector<std::uint32_t>& v, std::uint32_t id) {
+        if (std::find(v.begin(), v.end(), id) == v.end()) v.push_back(id);
+    };
+
+    // Level 0: a cell on a cluster's edge changes that border's entrances,
+    // and with them the nodes of the cluster across it
+    const Level& L0 = levels[0];
+    const int c  = int(L0.clusterOf({x, y}));
+    const int cx = x / L0.size, cy = y / L0.size;
+    const int lx = x - cx * L0.size, ly = y - cy * L0.size;
+    std::vector<std::uint32_t> borders, clusters{ std::uint32_t(c) };
+    auto touch = [&](std::uint32_t border, int neighbour) {
+        borders.push_back(border);
+        clusters.push_back(std::uint32_t(neighbour));
+    };
+    if (lx == L0.size - 1 && cx + 1 < L0.clustersX) touch(2 * c, c + 1);
+    if (lx == 0 && cx > 0)                          touch(2 * (c - 1), c - 1);
+    if (ly == L0.size - 1 && cy + 1 < L0.clustersY) touch(2 * c + 1, c + L0.clustersX);
+    if (ly == 0 && cy > 0)                          touch(2 * (c - L0.clustersX) + 1, c - L0.clustersX);
+    for (std::uint32_t b : borders) {
+        removeBorderNodes(0, b);
+        addEntrances(map, b);
+    }
+    for (std::uint32_t cl : clusters) linkCluster(map, 0, cl);
+
+    // Higher levels: re-promote the borders whose lower entrances or lower
+    // cluster links changed, then relink every cluster they touch
+    for (int level = 1; level < (int)levels.size(); ++level) {
+        const Level& lo = levels[level - 1];
+        const Level& L  = levels[level];
+        std::vector<std::uint32_t> upBorders, upClusters;
+        auto upCluster = [&](std::uint32_t lowerCluster) {
+            const int lcx = int(lowerCluster) % lo.clustersX, lcy = int(lowerCluster) / lo.clustersX;
+            return std::uint32_t((lcy / kLevelRatio) * L.clustersX + lcx / kLevelRatio);
+        };
+        for (std::uint32_t lc : clusters) {
+            const std::uint32_t uc = upCluster(lc);
+            addUnique(upClusters, uc);
+            const int lcx = int(lc) % lo.clustersX, lcy = int(lc) / lo.clustersX;
+            const int ucx = int(uc) % L.clustersX, ucy = int(uc) / L.clustersX;
+            if (lcx % kLevelRatio == kLevelRatio - 1 && ucx + 1 < L.clustersX) addUnique(upBorders, 2 * uc);
+            if (lcx % kLevelRatio == 0 && ucx > 0)                             addUnique(upBorders, 2 * (uc - 1));
+            if (lcy % kLevelRatio == kLevelRatio - 1 && ucy + 1 < L.clustersY) addUnique(upBorders, 2 * uc + 1);
+            if (lcy % kLevelRatio == 0 && ucy > 0)                             addUnique(upBorders, 2 * (uc - L.clustersX) + 1);
+        }
+        for (std::uint32_t b : borders) {
+            const std::uint32_t lc = b / 2;
+            const std::uint32_t across = (b & 1) == 0 ? lc + 1 : lc + lo.clustersX;
+            const std::uint32_t ua = upCluster(lc), ub = upCluster(across);
+            if (ua != ub) addUnique(upBorders, 2 * ua + (b & 1));
+        }
+        for (std::uint32_t b : upBorders) {
+            removeBorderNodes(level, b);
+            promoteBorder(level, b);
+            addUnique(upClusters, b / 2);
+            addUnique(upClusters, (b & 1) == 0 ? b / 2 + 1 : b / 2 + L.clustersX);
+        }
+        for (std::uint32_t uc : upClusters) linkCluster(map, level, uc);
+        borders  = std::move(upBorders);
+        clusters = std::move(upClusters);
+    }
+}
+
+void HierarchicalPathfinder::attach(const Map& map, int level, glm::ivec2 cell, Costs& out) const {
+    out.clear();
+    const Level& L = levels[level];
+    const std::uint32_t cluster = L.clusterOf(cell);
+    if (level == 0) {
+        const Rect r = clusterRect(0, cluster);
+        scratch.grid.load(map, r.x0, r.y0, r.x1, r.y1);
+        gridDijkstra(scratch.grid, cell, scratch.dist, nullptr);
+        for (std::uint32_t id : L.clusterNodes[cluster]) {
+            const std::uint32_t d = scratch.dist[scratch.grid.index(L.nodes[id].cell)];
+            if (d != kUnreached) out.push_back({ id, d });
+        }
+        return;
+    }
+
+    Costs lower;
+    attach(map, level - 1, cell, lower);
+    search(level - 1, clusterRect(level, cluster), lower, nullptr, {}, nullptr);
+    const GraphScratch& gs = scratch.levels[level - 1];
+    for (std::uint32_t id : L.clusterNodes[cluster]) {
+        const std::uint32_t lo = L.nodes[id].lower;
+        if (gs.stamp[lo] == gs.generation) out.push_back({ id, gs.g[lo] });
+    }
+}
+
+bool HierarchicalPathfinder::search(int level, const Rect& region, const Costs& seeds,
+                                    const Costs* targets, glm::ivec2 goal,
+                                    std::vector<std::uint32_t>* path) const {
+    const Level& L = levels[level];
+    if (scratch.levels.size() < levels.size()) scratch.levels.resize(levels.size());
+    GraphScratch& s = scratch.levels[level];
+
+    // Node n + 0 stands for the goal when searching toward targets
+    const std::uint32_t n = std::uint32_t(L.nodes.size());
+    const std::uint32_t G = n;
+    if (s.stamp.size() < n + 1 || s.generation == ~std::uint32_t(0)) {
+        for (auto* v : { &s.g, &s.parent, &s.stamp, &s.closed, &s.targetCost, &s.targetStamp })
+            v->assign(n + 1, 0);
+        s.generation = 0;
+    }
+    const std::uint32_t gen = ++s.generation;
+    if (targets) {
+        for (auto [id, cost] : *targets) {
+            s.targetCost[id]  = cost;
+            s.targetStamp[id] = gen;
+        }
+    }
+
+    auto heuristic = [&](std::uint32_t i) {
+        return targets && i != G ? octile(L.nodes[i].cell, goal) : 0u;
+    };
+    auto relax = [&](std::uint32_t i, std::uint32_t from, std::uint32_t g) {
+        if (s.closed[i] == gen || (s.stamp[i] == gen && g >= s.g[i])) return;
+        s.stamp[i]  = gen;
+        s.g[i]      = g;
+        s.parent[i] = from;
+        const std::uint64_t f = g + heuristic(i);
+        s.heap.push_back({ (f << 32) | ~g, i });
+        std::push_heap(s.heap.begin(), s.heap.end(), std::greater<>());
+    };
+
+    s.heap.clear();
+    for (auto [id, cost] : seeds) relax(id, kNoNode, cost);
+
+    bool found = false;
+    while (!s.heap.empty()) {
+        std::pop_heap(s.heap.begin(), s.heap.end(), std::greater<>());
+        const auto [key, i] = s.heap.back();
+        s.heap.pop_back();
+        if (s.closed[i] == gen || std::uint32_t(~key) != s.g[i]) continue;   // stale entry
+        s.closed[i] = gen;
+        if (i == G) { found = true; break; }
+
+        const std::uint32_t g = s.g[i];
+        if (targets && s.targetStamp[i] == gen) relax(G, i, g + s.targetCost[i]);
+        for (const Edge& e : L.nodes[i].edges)
+            if (region.contains(L.nodes[e.to].cell)) relax(e.to, i, g + e.cost);
+    }
+    if (!targets) return true;
+    if (!found) return false;
+
+    if (path) {
+        path->clear();
+        for (std::uint32_t i = s.parent[G]; i != kNoNode; i = s.parent[i]) path->push_back(i);
+        std::reverse(path->begin(), path->end());
+    }
+    return true;
+}
+
+bool HierarchicalPathfinder::route(const Map& map, int level, const Rect& region,
+                                   glm::ivec2 a, glm::ivec2 b,
+                                   std::vector<glm::ivec2>& waypoints) const {
+    Costs from, to;
+    attach(map, level, a, from);
+    if (from.empty()) return false;
+    attach(map, level, b, to);
+    if (to.empty()) return false;
+
+    std::vector<std::uint32_t> nodesOnPath;
+    if (!search(level, region, from, &to, b, &nodesOnPath)) return false;
+
+    waypoints.clear();
+    waypoints.push_back(a);
+    for (std::uint32_t id : nodesOnPath) {
+        const glm::ivec2 c = levels[level].nodes[id].cell;
+        if (waypoints.back() != c) waypoints.push_back(c);
+    }
+    if (waypoints.back() != b) waypoints.push_back(b);
+    return true;
+}
+
+bool HierarchicalPathfinder::findRoute(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                                       std::vector<glm::ivec2>& waypoints) const {
+    waypoints.clear();
+    auto walkable = [&](glm::ivec2 c) {
+        return (unsigned)c.x < (unsigned)w && (unsigned)c.y < (unsigned)h && !map.isWall(c.x, c.y);
+    };
+    if (!walkable(start) || !walkable(goal)) return false;
+    if (start == goal) {
+        waypoints.push_back(start);
+        return true;
+    }
+
+    // Smallest region holding both ends first: the grid of their level-0
+    // cluster, then level k - 1's graph inside their level-k cluster, then
+    // the top level over the whole map
+    const int top = (int)levels.size();
+    for (int k = 0; k <= top; ++k) {
+        if (k < top && levels[k].clusterOf(start) != levels[k].clusterOf(goal)) continue;
+        if (k == 0) {
+            const Rect r = clusterRect(0, levels[0].clusterOf(start));
+            scratch.grid.load(map, r.x0, r.y0, r.x1, r.y1);
+            gridDijkstra(scratch.grid, start, scratch.dist, nullptr);
+            if (scratch.dist[scratch.grid.index(goal)] == kUnreached) continue;
+            waypoints = { start, goal };
+            return true;
+        }
+        const Rect region = k < top ? clusterRect(k, levels[k].clusterOf(start)) : Rect{ 0, 0, w, h };
+        if (route(map, k - 1, region, start, goal, waypoints)) return true;
+    }
+    return false;
+}
+
+bool HierarchicalPathfinder::refine(const Map& map, glm::ivec2 a, glm::ivec2 b,
+                                    std::vector<glm::ivec2>& cells) const {
+    if (a == b) return true;
+    for (int k = 0; k < 8; ++k) {
+        if (a + glm::ivec2(kDX[k], kDY[k]) == b && canStep(map, a, k)) {
+            cells.push_back(b);
+            return true;
+        }
+    }
+
+    // Same ladder as findRoute. A level-0 leg is walked on the grid; a
+    // higher one becomes a lower-level route whose legs are refined in turn.
+    const int top = (int)levels.size();
+    for (int k = 0; k <= top; ++k) {
+        if (k < top && levels[k].clusterOf(a) != levels[k].clusterOf(b)) continue;
+        if (k == 0) {
+            const Rect r = clusterRect(0, levels[0].clusterOf(a));
+            scratch.grid.load(map, r.x0, r.y0, r.x1, r.y1);
+            gridDijkstra(scratch.grid, b, scratch.dist, &scratch.step);
+            if (scratch.dist[scratch.grid.index(a)] == kUnreached) continue;
+            for (glm::ivec2 c = a; c != b; ) {
+                const int s = scratch.step[scratch.grid.index(c)];
+                c += glm::ivec2(kDX[s], kDY[s]);
+                cells.push_back(c);
+            }
+            return true;
+        }
+        const Rect region = k < top ? clusterRect(k, levels[k].clusterOf(a)) : Rect{ 0, 0, w, h };
+        std::vector<glm::ivec2> legs;
+        if (!route(map, k - 1, region, a, b, legs)) continue;
+        for (std::size_t i = 1; i < legs.size(); ++i)
+            if (!refine(map, legs[i - 1], legs[i], cells)) return false;
+        return true;
+    }
+    return false;
+}
+
+bool HierarchicalPathfinder::findPath(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                                      std::vector<glm::ivec2>& cells) const {
+    cells.clear();
+    std::vector<glm::ivec2> waypoints;
+    if (!findRoute(map, start, goal, waypoints)) return false;
+    cells.push_back(start);
+    for (std::size_t i = 1; i < waypoints.size(); ++i)
+        if (!refine(map, waypoints[i - 1], waypoints[i], cells)) return false;
+    return true;
+}
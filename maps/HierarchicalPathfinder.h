@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+class ThreadPool;
+
+// HPA*: the map is cut into square clusters, and every stretch of open
+// border between two clusters gets one or two entrances (a node on each
+// side joined by a single step). Within a cluster, entrance nodes are joined
+// by the cost of their shortest path inside it. A query searches this small
+// graph instead of the grid. The result is a route of waypoints that
+// refine() expands into cells one leg at a time, as an agent needs them.
+//
+// Large maps stack further levels: clusters 4x wider whose entrances are
+// the lower-level entrances on their borders, with costs found on the
+// lower-level graph. Of several entrances in one lower border segment that
+// are joined on both sides, only one is promoted, so every level keeps a
+// few dozen nodes per cluster. Queries search the highest level that
+// separates start and goal.
+//
+// Step costs match FlowField: 2 straight, 3 diagonal, no corner cutting.
+// Paths are near-optimal: a few percent longer than the shortest on
+// average, more for short paths that detour through an entrance.
+// Unreachable goals make the search visit every node of the start's
+// region, so check MapRegions::sameRegion first.
+class HierarchicalPathfinder {
+public:
+    static constexpr std::uint32_t kUnreached = ~std::uint32_t(0);
+
+    // pool (optional) spreads the per-cluster cost searches over workers.
+    // Levels are added while the one below spans more than 4 clusters.
+    void build(const Map& map, int clusterSize = 16, ThreadPool* pool = nullptr);
+
+    // Patch the clusters around a changed cell (call after Map::setWall)
+    void updateCell(const Map& map, int x, int y);
+
+    // Route from start to goal: waypoint cells, start first and goal last.
+    // Consecutive waypoints are joined by a path inside one cluster or by a
+    // single step across a border. Returns false when no route exists.
+    // Safe to call from several threads at once.
+    bool findRoute(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                   std::vector<glm::ivec2>& waypoints) const;
+
+    // Append the cells from waypoint a to the next waypoint b (b included,
+    // a not) to cells. Returns false if a and b are not joined.
+    bool refine(const Map& map, glm::ivec2 a, glm::ivec2 b, std::vector<glm::ivec2>& cells) const;
+
+    // findRoute followed by refine over every leg
+    bool findPath(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                  std::vector<glm::ivec2>& cells) const;
+
+    int levelCount() const { return (int)levels.size(); }
+    std::size_t nodeCount(int level = 0) const {
+        return levels[level].nodes.size() - levels[level].freeNodes.size();
+    }
+    int clusterSize() const { return levels.empty() ? 0 : levels[0].size; }
+
+private:
+    static constexpr std::uint32_t kNone = ~std::uint32_t(0);
+
+    struct Edge {
+        std::uint32_t to;
+        std::uint32_t cost;
+        bool          inter;   // step across a border (kept when intra edges are rebuilt)
+    };
+    struct Node {
+        glm::ivec2        cell;
+        std::uint32_t     cluster;
+        std::uint32_t     border;          // border whose entrance created it
+        std::uint32_t     lower = kNone;   // same entrance one level down
+        std::uint32_t     upper = kNone;   // and one level up, if promoted
+        std::vector<Edge> edges;
+    };
+    struct Rect {
+        int x0, y0, x1, y1;
+        bool contains(glm::ivec2 c) const { return c.x >= x0 && c.x < x1 && c.y >= y0 && c.y < y1; }
+    };
+    // Border ids: 2 c is the east border of cluster c, 2 c + 1 its south one
+    struct Level {
+        int size = 0;                      // cluster side in cells
+        int clustersX = 0, clustersY = 0;
+        std::vector<Node>                       nodes;
+        std::vector<std::uint32_t>              freeNodes;
+        std::vector<std::vector<std::uint32_t>> clusterNodes;
+        std::uint32_t clusterOf(glm::ivec2 c) const {
+            return std::uint32_t((c.y / size) * clustersX + c.x / size);
+        }
+    };
+    using Costs = std::vector<std::pair<std::uint32_t, std::uint32_t>>;   // (node, cost)
+
+    Rect clusterRect(int level, std::uint32_t cluster) const;
+    std::uint32_t newNode(int level, glm::ivec2 cell, std::uint32_t border, std::uint32_t lower);
+    void addEntrances(const Map& map, std::uint32_t border);
+    void promoteBorder(int level, std::uint32_t border);
+    void removeBorderNodes(int level, std::uint32_t border);
+    void linkCluster(const Map& map, int level, std::uint32_t cluster);
+
+    // Costs from cell to the nodes of its cluster at level, through the
+    // levels below (the grid for level 0)
+    void attach(const Map& map, int level, glm::ivec2 cell, Costs& out) const;
+    // Best-first search over level's nodes inside region, starting from the
+    // seeds. With targets it is A* toward goal that stops at the cheapest
+    // (node cost + target cost) and writes the node path; without, it is
+    // Dijkstra over the whole region.
+    bool search(int level, const Rect& region, const Costs& seeds, const Costs* targets,
+                glm::ivec2 goal, std::vector<std::uint32_t>* path) const;
+    // Waypoints from a to b using level's graph inside region
+    bool route(const Map& map, int level, const Rect& region, glm::ivec2 a, glm::ivec2 b,
+               std::vector<glm::ivec2>& waypoints) const;
+
+    int w = 0, h = 0;
+    std::vector<Level> levels;
+};
@@ -0,0 +1,346 @@
+#include "JumpPointSearch.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace {
+
+// Same neighbourhood and weights as FlowField: straight steps first
+constexpr int kDX[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+constexpr int kDY[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+constexpr std::uint32_t kStepCost[8] = { 2, 2, 2, 2, 3, 3, 3, 3 };
+constexpr std::uint32_t kUnreached = ~std::uint32_t(0);
+constexpr std::uint32_t kNoCell    = ~std::uint32_t(0);
+constexpr std::uint8_t  kStartDir  = 8;
+
+// Directions worth jumping in from a node, by the direction it was reached
+// in (kStartDir for the start). After a straight move that is ahead, both
+// sides and the two diagonals ahead; after a diagonal move, ahead and its
+// two straight parts. Steps that turn out blocked find no jump point.
+struct Successors {
+    int count;
+    int dirs[8];
+};
+constexpr Successors kSuccessors[9] = {
+    { 5, { 0, 2, 3, 4, 6 } }, { 5, { 1, 2, 3, 5, 7 } },
+    { 5, { 2, 0, 1, 4, 5 } }, { 5, { 3, 0, 1, 6, 7 } },
+    { 3, { 4, 0, 2 } }, { 3, { 5, 1, 2 } }, { 3, { 6, 0, 3 } }, { 3, { 7, 1, 3 } },
+    { 8, { 0, 1, 2, 3, 4, 5, 6, 7 } },
+};
+
+// Straight parts of each diagonal
+constexpr int horizontalOf(int dir) { return kDX[dir] > 0 ? 0 : 1; }
+constexpr int verticalOf(int dir)   { return kDY[dir] > 0 ? 2 : 3; }
+
+std::uint32_t octile(glm::ivec2 a, glm::ivec2 b) {
+    const int dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+    return std::uint32_t(3 * std::min(dx, dy) + 2 * std::abs(dx - dy));
+}
+
+bool isFree(const Map& map, int x, int y) {
+    return (unsigned)x < (unsigned)map.width() && (unsigned)y < (unsigned)map.height() && !map.isWall(x, y);
+}
+
+bool canStep(const Map& map, glm::ivec2 c, int k) {
+    const int nx = c.x + kDX[k], ny = c.y + kDY[k];
+    if (!isFree(map, nx, ny)) return false;
+    return k < 4 || (isFree(map, nx, c.y) && isFree(map, c.x, ny));
+}
+
+// 64 cells of row r starting at cell s (bit i = cell s + i). Cells off the
+// grid read as wall so scans stop at the map edge.
+std::uint64_t window(const OccupancyGrid& g, int r, int s) {
+    if ((unsigned)r >= (unsigned)g.height()) return ~std::uint64_t(0);
+    const std::uint64_t* row = g.row(r);
+    const std::size_t i = std::size_t(s) >> 6, stride = g.wordsPerRow();
+    const int shift = s & 63;
+    const std::uint64_t lo = i < stride ? row[i] : 0;
+    const std::uint64_t hi = i + 1 < stride ? row[i + 1] : 0;
+    std::uint64_t bits = shift ? (lo >> shift) | (hi << (64 - shift)) : lo;
+    const int inside = g.width() - s;
+    if (inside < 64) bits |= inside <= 0 ? ~std::uint64_t(0) : ~std::uint64_t(0) << inside;
+    return bits;
+}
+
+// 64 cells of row r ending at cell e (bit 63 = cell e, bit 63 - i = cell e - i)
+std::uint64_t windowDown(const OccupancyGrid& g, int r, int e) {
+    if (e < 0) return ~std::uint64_t(0);
+    if (e >= 63) return window(g, r, e - 63);
+    const int below = 63 - e;
+    return (window(g, r, 0) << below) | ((std::uint64_t(1) << below) - 1);
+}
+
+// Jump along row r of g from cell p, toward higher or lower cells. A cell
+// is a jump point when a side neighbour is free but the one beside the cell
+// we came from is a wall, or when it is goalCell (-1 for none). Returns
+// the steps to the first wall (not found) or jump point (found).
+std::pair<int, bool> scanRow(const OccupancyGrid& g, int r, int p, bool forward, int goalCell) {
+    if (forward) {
+        for (int s = p + 1; ; s += 64) {
+            const std::uint64_t wall   = window(g, r, s);
+            const std::uint64_t forced = (~window(g, r - 1, s) & window(g, r - 1, s - 1)) |
+                                         (~window(g, r + 1, s) & window(g, r + 1, s - 1));
+            std::uint64_t stop = wall | forced;
+            if (goalCell >= s && goalCell - s < 64) stop |= std::uint64_t(1) << (goalCell - s);
+            if (stop) {
+                const int i = std::countr_zero(stop);
+                return (wall >> i) & 1 ? std::pair(i, false) : std::pair(i + 1, true);
+            }
+        }
+    }
+    for (int e = p - 1; ; e -= 64) {
+        const std::uint64_t wall   = windowDown(g, r, e);
+        const std::uint64_t forced = (~windowDown(g, r - 1, e) & windowDown(g, r - 1, e + 1)) |
+                                     (~windowDown(g, r + 1, e) & windowDown(g, r + 1, e + 1));
+        std::uint64_t stop = wall | forced;
+        if (goalCell >= 0 && goalCell <= e && e - goalCell < 64) stop |= std::uint64_t(1) << (63 - (e - goalCell));
+        if (stop) {
+            const int i = std::countl_zero(stop);
+            return (wall >> (63 - i)) & 1 ? std::pair(i, false) : std::pair(i + 1, true);
+        }
+    }
+}
+
+// Open-addressed map from cell index to search state; a search only touches
+// the jump points it reaches, far fewer than the map's cells
+struct NodeTable {
+    struct Slot {
+        std::uint32_t cell = 0, g = kUnreached, parent = kNoCell, stamp = 0;
+        std::uint8_t  dir = kStartDir;
+        bool          closed = false;
+    };
+    std::vector<Slot> slots;
+    std::uint32_t     generation = 0;
+    std::size_t       used = 0;
+    int               bits = 0;
+
+    void clear() {
+        if (slots.empty()) {
+            bits = 12;
+            slots.assign(std::size_t(1) << bits, {});
+        }
+        if (++generation == 0) {
+            for (Slot& s : slots) s.stamp = 0;
+            generation = 1;
+        }
+        used = 0;
+    }
+
+    // Slot of cell, added with no cost yet if new. Invalidated by the next call.
+    Slot& at(std::uint32_t cell) {
+        if (2 * (used + 1) > slots.size()) grow();
+        Slot& s = probe(cell);
+        if (s.stamp != generation) {
+            s = Slot{ cell, kUnreached, kNoCell, generation, kStartDir, false };
+            ++used;
+        }
+        return s;
+    }
+
+private:
+    Slot& probe(std::uint32_t cell) {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = std::size_t((cell * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+        while (slots[i].stamp == generation && slots[i].cell != cell) i = (i + 1) & mask;
+        return slots[i];
+    }
+    void grow() {
+        std::vector<Slot> old = std::move(slots);
+        ++bits;
+        slots.assign(std::size_t(1) << bits, {});
+        for (const Slot& s : old)
+            if (s.stamp == generation) probe(s.cell) = s;
+    }
+};
+
+// Per-thread search state, so const queries can run concurrently
+struct Scratch {
+    NodeTable nodes;
+    // (f, ~g) packed so that among equal f the deeper node pops first
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> heap;
+};
+thread_local Scratch scratch;
+
+} // namespace
+
+void JumpPointSearch::build(const Map& map, std::size_t maxTableCells) {
+    w = map.width();
+    h = map.height();
+
+    // Transpose a set bit at a time; walls are a small share of most maps
+    columns.resize(h, w);
+    for (int y = 0; y < h; ++y) {
+        const std::uint64_t* row = map.walls.row(y);
+        for (std::size_t i = 0; i < map.walls.wordsPerRow(); ++i)
+            for (std::uint64_t bits = row[i]; bits; bits &= bits - 1)
+                columns.set(y, int(i * 64) + std::countr_zero(bits), true);
+    }
+
+    jumps.clear();
+    jumps.shrink_to_fit();
+    if (std::size_t(w) * h <= maxTableCells && std::max(w, h) < 32768) buildJumpTable(map);
+}
+
+void JumpPointSearch::updateCell(const Map& map, int x, int y) {
+    if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return;
+    columns.set(y, x, map.isWall(x, y));
+    jumps.clear();
+    jumps.shrink_to_fit();
+}
+
+void JumpPointSearch::buildJumpTable(const Map& map) {
+    jumps.assign(std::size_t(w) * h * 8, 0);
+    auto entry = [&](int x, int y, int dir) -> std::int16_t& {
+        return jumps[(std::size_t(y) * w + x) * 8 + dir];
+    };
+    // Visit cells against dir, so each cell's neighbour ahead is done first
+    auto sweep = [&](int dir, auto&& body) {
+        const int xs = kDX[dir] > 0 ? w - 1 : 0, xstep = kDX[dir] > 0 ? -1 : 1;
+        const int ys = kDY[dir] > 0 ? h - 1 : 0, ystep = kDY[dir] > 0 ? -1 : 1;
+        for (int y = ys, j = 0; j < h; y += ystep, ++j)
+            for (int x = xs, i = 0; i < w; x += xstep, ++i)
+                if (!map.isWall(x, y)) body(x, y);
+    };
+
+    // Straight: the step lands on a jump point (a free side cell next to a
+    // walled one behind it), a wall, or the previous result plus one
+    for (int dir = 0; dir < 4; ++dir) {
+        const int px = kDY[dir] != 0, py = kDX[dir] != 0;   // perpendicular
+        sweep(dir, [&](int x, int y) {
+            const int nx = x + kDX[dir], ny = y + kDY[dir];
+            std::int16_t& out = entry(x, y, dir);
+            if (!isFree(map, nx, ny)) { out = 0; return; }
+            const bool forced =
+                (isFree(map, nx + px, ny + py) && !isFree(map, x + px, y + py)) ||
+                (isFree(map, nx - px, ny - py) && !isFree(map, x - px, y - py));
+            const std::int16_t next = entry(nx, ny, dir);
+            out = forced ? 1 : next > 0 ? next + 1 : next - 1;
+        });
+    }
+
+    // Diagonal: the step lands on a jump point when either straight part
+    // from there finds one
+    for (int dir = 4; dir < 8; ++dir) {
+        sweep(dir, [&](int x, int y) {
+            std::int16_t& out = entry(x, y, dir);
+            if (!canStep(map, {x, y}, dir)) { out = 0; return; }
+            const int nx = x + kDX[dir], ny = y + kDY[dir];
+            const std::int16_t next = entry(nx, ny, dir);
+            const bool turn = entry(nx, ny, horizontalOf(dir)) > 0 || entry(nx, ny, verticalOf(dir)) > 0;
+            out = turn ? 1 : next > 0 ? next + 1 : next - 1;
+        });
+    }
+}
+
+JumpPointSearch::Jump JumpPointSearch::scanStraight(const Map& map, glm::ivec2 from, int dir,
+                                                    glm::ivec2 goal) const {
+    const bool horizontal = dir < 2;
+    const OccupancyGrid& g = horizontal ? map.walls : columns;
+    const int r = horizontal ? from.y : from.x;
+    const int p = horizontal ? from.x : from.y;
+    const int goalCell = (horizontal ? goal.y : goal.x) == r ? (horizontal ? goal.x : goal.y) : -1;
+    const auto [steps, found] = scanRow(g, r, p, (dir & 1) == 0, goalCell);
+    return { steps, found };
+}
+
+JumpPointSearch::Jump JumpPointSearch::scanDiagonal(const Map& map, glm::ivec2 from, int dir,
+                                                    glm::ivec2 goal) const {
+    const glm::ivec2 step(kDX[dir], kDY[dir]);
+    glm::ivec2 c = from;
+    for (int steps = 1; canStep(map, c, dir); ++steps) {
+        c += step;
+        if (c == goal || scanStraight(map, c, horizontalOf(dir), goal).found ||
+            scanStraight(map, c, verticalOf(dir), goal).found)
+            return { steps, true };
+    }
+    return {};
+}
+
+JumpPointSearch::Jump JumpPointSearch::jump(const Map& map, glm::ivec2 from, int dir,
+                                            glm::ivec2 goal) const {
+    if (jumps.empty()) return dir < 4 ? scanStraight(map, from, dir, goal) : scanDiagonal(map, from, dir, goal);
+
+    // The table doesn't know the goal: stop on it when it lies ahead within
+    // reach, and on a diagonal where the goal's row or column is crossed
+    const int entry = jumps[(std::size_t(from.y) * w + from.x) * 8 + dir];
+    const int reach = std::abs(entry);
+    const int gx = (goal.x - from.x) * kDX[dir], gy = (goal.y - from.y) * kDY[dir];
+    int toGoal;
+    if (dir < 4) toGoal = kDX[dir] ? (goal.y == from.y ? gx : 0) : (goal.x == from.x ? gy : 0);
+    else         toGoal = std::min(gx, gy);
+    if (toGoal > 0 && toGoal <= reach) return { toGoal, true };
+    if (entry > 0) return { entry, true };
+    return {};
+}
+
+bool JumpPointSearch::findJumpPoints(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                                     std::vector<glm::ivec2>& points) const {
+    points.clear();
+    if (map.width() != w || map.height() != h) return false;
+    if (!isFree(map, start.x, start.y) || !isFree(map, goal.x, goal.y)) return false;
+    if (start == goal) {
+        points.push_back(start);
+        return true;
+    }
+
+    auto indexOf = [&](glm::ivec2 c) { return std::uint32_t(std::size_t(c.y) * w + c.x); };
+    auto cellOf  = [&](std::uint32_t i) { return glm::ivec2(int(i % w), int(i / w)); };
+    NodeTable& nodes = scratch.nodes;
+    auto& heap = scratch.heap;
+    nodes.clear();
+    heap.clear();
+
+    auto push = [&](glm::ivec2 c, std::uint32_t g, std::uint32_t parent, int dir) {
+        NodeTable::Slot& s = nodes.at(indexOf(c));
+        if (s.closed || g >= s.g) return;
+        s.g      = g;
+        s.parent = parent;
+        s.dir    = std::uint8_t(dir);
+        const std::uint64_t f = g + octile(c, goal);
+        heap.push_back({ (f << 32) | ~g, indexOf(c) });
+        std::push_heap(heap.begin(), heap.end(), std::greater<>());
+    };
+    push(start, 0, kNoCell, kStartDir);
+
+    const std::uint32_t target = indexOf(goal);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        const auto [key, i] = heap.back();
+        heap.pop_back();
+        NodeTable::Slot& s = nodes.at(i);
+        if (s.closed || std::uint32_t(~key) != s.g) continue;   // stale entry
+        s.closed = true;
+
+        if (i == target) {
+            for (std::uint32_t c = i; c != kNoCell; c = nodes.at(c).parent) points.push_back(cellOf(c));
+            std::reverse(points.begin(), points.end());
+            return true;
+        }
+
+        const glm::ivec2 c = cellOf(i);
+        const std::uint32_t g = s.g;
+        const Successors& next = kSuccessors[s.dir];
+        for (int k = 0; k < next.count; ++k) {
+            const int dir = next.dirs[k];
+            const Jump j = jump(map, c, dir, goal);
+            if (!j.found) continue;
+            push(c + j.steps * glm::ivec2(kDX[dir], kDY[dir]), g + std::uint32_t(j.steps) * kStepCost[dir], i, dir);
+        }
+    }
+    return false;
+}
+
+bool JumpPointSearch::findPath(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                               std::vector<glm::ivec2>& cells) const {
+    cells.clear();
+    std::vector<glm::ivec2> points;
+    if (!findJumpPoints(map, start, goal, points)) return false;
+    cells.push_back(points.front());
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        const glm::ivec2 step = glm::sign(points[i] - points[i - 1]);
+        while (cells.back() != points[i]) cells.push_back(cells.back() + step);
+    }
+    return true;
+}
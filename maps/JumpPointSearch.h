@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+#include "OccupancyGrid.h"
+
+// Jump Point Search: optimal A* on the uniform-cost 8-connected grid that
+// only expands jump points. These are cells where a shortest path may have
+// to turn. Straight runs are jumped with 64-cell scans of the bit-packed
+// wall rows, and column runs with the same scans over a transposed copy of
+// the walls. For maps up to a size limit, build() also precomputes the
+// distance to the next jump point or wall in all 8 directions of every
+// cell (JPS+), so each jump becomes one table read.
+//
+// Step costs match FlowField: 2 straight, 3 diagonal, no corner cutting.
+// Unreachable goals make the search visit every jump point of the start's
+// region, so check MapRegions::sameRegion first.
+class JumpPointSearch {
+public:
+    // 8 directions x 2 bytes per cell: 64 MB at this size
+    static constexpr std::size_t kDefaultTableCells = std::size_t(1) << 22;
+
+    // Transpose the walls and, if the map has at most maxTableCells cells,
+    // precompute the JPS+ jump table
+    void build(const Map& map, std::size_t maxTableCells = kDefaultTableCells);
+
+    // Follow a changed cell (call after Map::setWall). The jump table can't
+    // be patched locally, so it is dropped and queries scan until the next
+    // build().
+    void updateCell(const Map& map, int x, int y);
+
+    // Jump points from start to goal, start first and goal last. Each pair
+    // of consecutive points shares a row, column or diagonal with free
+    // cells in between. Returns false when no path exists.
+    // Safe to call from several threads at once.
+    bool findJumpPoints(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                        std::vector<glm::ivec2>& points) const;
+
+    // findJumpPoints expanded into every cell of the path, start included
+    bool findPath(const Map& map, glm::ivec2 start, glm::ivec2 goal,
+                  std::vector<glm::ivec2>& cells) const;
+
+    bool hasJumpTable() const { return !jumps.empty(); }
+    std::size_t memoryBytes() const {
+        return columns.memoryBytes() + jumps.size() * sizeof(std::int16_t);
+    }
+
+private:
+    // Result of jumping from a cell in one direction: the jump point found
+    // (steps > 0) or none
+    struct Jump {
+        int  steps = 0;
+        bool found = false;
+    };
+
+    Jump jump(const Map& map, glm::ivec2 from, int dir, glm::ivec2 goal) const;
+    Jump scanStraight(const Map& map, glm::ivec2 from, int dir, glm::ivec2 goal) const;
+    Jump scanDiagonal(const Map& map, glm::ivec2 from, int dir, glm::ivec2 goal) const;
+    void buildJumpTable(const Map& map);
+
+    int w = 0, h = 0;
+    OccupancyGrid             columns;   // walls transposed: row x holds column x
+    // JPS+ table, 8 entries per cell: n > 0 is a jump point n steps away,
+    // n <= 0 a dead end -n steps away
+    std::vector<std::int16_t> jumps;
+};
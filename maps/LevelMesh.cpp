@@ -0,0 +1,108 @@
+#include "LevelMesh.h"
+#include "ThreadPool.h"
+#include "WallRects.h"
+
+#include <algorithm>
+
+namespace {
+
+// Append the quad o, o + u, o + u + v, o + v as two triangles. u x v must
+// point along n, which makes the winding counter-clockwise from outside.
+void quad(std::vector<float>& out, glm::vec3 o, glm::vec3 u, glm::vec3 v, glm::vec3 n) {
+    const glm::vec3 p[4] = { o, o + u, o + u + v, o + v };
+    const float lu = glm::length(u), lv = glm::length(v);
+    const glm::vec2 t[4] = { { 0.0f, 0.0f }, { lu, 0.0f }, { lu, lv }, { 0.0f, lv } };
+    for (int i : { 0, 1, 2, 0, 2, 3 }) {
+        out.insert(out.end(), { p[i].x, p[i].y, p[i].z, n.x, n.y, n.z, t[i].x, t[i].y });
+    }
+}
+
+// Exposed faces of the wall cells in [x0, x1) x [y0, y1)
+void meshChunk(const Map& map, const LevelMesh::Settings& s, int x0, int y0, int x1, int y1,
+               std::vector<float>& out) {
+    const float height = s.wallHeight, base = -s.wallHeight, side = height - base;
+    const int mh = map.height();
+    auto floorAt = [&](int x, int y) {
+        return (unsigned)x < (unsigned)map.width() && (unsigned)y < (unsigned)mh && !map.isWall(x, y);
+    };
+
+    // Tops: one quad per merged rect
+    if (s.tops) for (const WallRect& r : mergeWallRects(map, x0, y0, x1, y1)) {
+        const glm::vec3 lo = wallRectMin(map, r), hi = wallRectMax(map, r, height);
+        quad(out, { lo.x, height, lo.z }, { 0.0f, 0.0f, hi.z - lo.z }, { hi.x - lo.x, 0.0f, 0.0f }, { 0, 1, 0 });
+    }
+
+    // Sides facing the row above (world +z) or below (-z): runs along x
+    for (int y = y0; y < y1; ++y) {
+        for (int dir : { -1, 1 }) {
+            auto exposed = [&](int x) { return map.isWall(x, y) && floorAt(x, y + dir); };
+            for (int x = x0; x < x1; ) {
+                if (!exposed(x)) { ++x; continue; }
+                int end = x + 1;
+                while (end < x1 && exposed(end)) ++end;
+                const float len = float(end - x);
+                if (dir < 0) quad(out, { float(x), base, float(mh - y) }, { len, 0, 0 }, { 0, side, 0 }, { 0, 0, 1 });
+                else         quad(out, { float(x), base, float(mh - 1 - y) }, { 0, side, 0 }, { len, 0, 0 }, { 0, 0, -1 });
+                x = end;
+            }
+        }
+    }
+
+    // Sides facing the next column (+x) or the previous one (-x): runs
+    // along y, which runs toward -z in the world
+    for (int x = x0; x < x1; ++x) {
+        for (int dir : { -1, 1 }) {
+            auto exposed = [&](int y) { return map.isWall(x, y) && floorAt(x + dir, y); };
+            for (int y = y0; y < y1; ) {
+                if (!exposed(y)) { ++y; continue; }
+                int end = y + 1;
+                while (end < y1 && exposed(end)) ++end;
+                const float len = float(end - y);
+                const glm::vec3 o(float(dir > 0 ? x + 1 : x), base, float(mh - end));
+                if (dir > 0) quad(out, o, { 0, side, 0 }, { 0, 0, len }, { 1, 0, 0 });
+                else         quad(out, o, { 0, 0, len }, { 0, side, 0 }, { -1, 0, 0 });
+                y = end;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void LevelMesh::build(const Map& map, const Settings& settings, ThreadPool* pool) {
+    const int chunkSize = std::max(settings.chunkSize, 1);
+    const int cx = (map.width() + chunkSize - 1) / chunkSize;
+    const int cy = (map.height() + chunkSize - 1) / chunkSize;
+
+    std::vector<std::vector<float>> meshed(std::size_t(cx) * cy);
+    auto meshChunks = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const int x0 = int(i % cx) * chunkSize, y0 = int(i / cx) * chunkSize;
+            meshChunk(map, settings, x0, y0, std::min(x0 + chunkSize, map.width()),
+                      std::min(y0 + chunkSize, map.height()), meshed[i]);
+        }
+    };
+    if (pool) pool->parallelFor(meshed.size(), 16, meshChunks);
+    else      meshChunks(0, meshed.size());
+
+    std::size_t total = 0;
+    for (const auto& m : meshed) total += m.size();
+    data.clear();
+    data.reserve(total);
+    parts.clear();
+    for (std::size_t i = 0; i < meshed.size(); ++i) {
+        if (meshed[i].empty()) continue;
+        Chunk c;
+        c.first = std::uint32_t(data.size() / kFloatsPerVertex);
+        c.count = std::uint32_t(meshed[i].size() / kFloatsPerVertex);
+        c.x0 = int(i % cx) * chunkSize;
+        c.y0 = int(i / cx) * chunkSize;
+        c.x1 = std::min(c.x0 + chunkSize, map.width());
+        c.y1 = std::min(c.y0 + chunkSize, map.height());
+        c.lo = { float(c.x0), -settings.wallHeight, float(map.height() - c.y1) };
+        c.hi = { float(c.x1), settings.wallHeight, float(map.height() - c.y0) };
+        data.insert(data.end(), meshed[i].begin(), meshed[i].end());
+        parts.push_back(c);
+        std::vector<float>().swap(meshed[i]);
+    }
+}
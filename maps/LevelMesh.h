@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+class ThreadPool;
+
+// Static wall geometry with hidden faces removed. A wall side is emitted
+// only where it borders a floor cell inside the map. Bottoms and faces
+// buried between two walls are dropped, and so are tops when the eye can
+// never rise above them. Coplanar exposed faces are merged greedily into
+// long quads: sides into runs along their wall line, tops into the same
+// rectangles as mergeWallRects. Walls span y in [-wallHeight, wallHeight],
+// the same box as an instanced wall cube.
+//
+// Faces are grouped by square chunk of cells and never cross a chunk edge,
+// so each chunk is one contiguous vertex range that can be culled on its own.
+class LevelMesh {
+public:
+    static constexpr int kFloatsPerVertex = 8;   // position, normal, uv (Mesh layout)
+
+    struct Chunk {
+        std::uint32_t first = 0, count = 0;   // vertex range
+        int           x0 = 0, y0 = 0, x1 = 0, y1 = 0;   // cells [x0, x1) x [y0, y1)
+        glm::vec3     lo{ 0.0f }, hi{ 0.0f };   // world bounds
+    };
+
+    struct Settings {
+        float wallHeight = 3.0f;
+        int   chunkSize  = 32;     // cells per chunk side
+        bool  tops       = true;   // false: the eye stays below the wall tops
+    };
+
+    // pool (optional) meshes chunks in parallel
+    void build(const Map& map, const Settings& settings, ThreadPool* pool = nullptr);
+
+    // Triangle list, kFloatsPerVertex floats per vertex, counter-clockwise
+    // seen from outside
+    const std::vector<float>& vertices() const { return data; }
+    std::size_t vertexCount() const { return data.size() / kFloatsPerVertex; }
+    // Chunks with at least one face
+    const std::vector<Chunk>& chunks() const { return parts; }
+
+private:
+    std::vector<float> data;
+    std::vector<Chunk> parts;
+};
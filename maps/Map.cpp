@@ -1,27 +1,140 @@
 #include "Map.h"
+#include "MapFormat.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define T3V_PARSE_SSE2 1
+#endif
+
+namespace {
+
+// Classify 64 map characters: bit i of the result is set when p[i] is a
+// wall, bit i of markers when p[i] is a spawn marker ('P' or 'Z')
+std::uint64_t classify64(const unsigned char* p, std::uint64_t& markers) {
+#if defined(__AVX2__)
+    const __m256i wall = _mm256_set1_epi8('#');
+    const __m256i player = _mm256_set1_epi8('P');
+    const __m256i zombie = _mm256_set1_epi8('Z');
+    std::uint64_t walls = 0;
+    markers = 0;
+    for (int half = 0; half < 2; ++half) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + half * 32));
+        std::uint32_t w = (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, wall));
+        std::uint32_t m = (std::uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, player), _mm256_cmpeq_epi8(c, zombie)));
+        walls   |= std::uint64_t(w) << (half * 32);
+        markers |= std::uint64_t(m) << (half * 32);
+    }
+    return walls;
+#elif defined(T3V_PARSE_SSE2)
+    const __m128i wall = _mm_set1_epi8('#');
+    const __m128i player = _mm_set1_epi8('P');
+    const __m128i zombie = _mm_set1_epi8('Z');
+    std::uint64_t walls = 0;
+    markers = 0;
+    for (int q = 0; q < 4; ++q) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + q * 16));
+        std::uint32_t w = (std::uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, wall));
+        std::uint32_t m = (std::uint32_t)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(c, player), _mm_cmpeq_epi8(c, zombie)));
+        walls   |= std::uint64_t(w) << (q * 16);
+        markers |= std::uint64_t(m) << (q * 16);
+    }
+    return walls;
+#else
+    std::uint64_t walls = 0;
+    markers = 0;
+    for (int i = 0; i < 64; ++i) {
+        walls   |= std::uint64_t(p[i] == '#') << i;
+        markers |= std::uint64_t(p[i] == 'P' || p[i] == 'Z') << i;
+    }
+    return walls;
+#endif
+}
+
+// Length of the line starting at p (up to '\n' or end), without a trailing '\r'
+std::size_t lineLength(const char* p, const char* end, const char*& next) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', std::size_t(end - p)));
+    const char* stop = nl ? nl : end;
+    next = nl ? nl + 1 : end;
+    std::size_t len = std::size_t(stop - p);
+    if (len > 0 && stop[-1] == '\r') --len;
+    return len;
+}
+
+} // namespace
 
 bool Map::load(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in) return false;
-    grid.clear();
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename)) {
+        // Mapping fails for empty files too; those are valid, empty maps
+        std::ifstream in(filename);
+        if (!in) return false;
+        parse({});
+        return true;
+    }
+    if (isBinaryMap(file->data(), file->size())) return loadBinaryMap(*this, std::move(file), filename);
+
+    parse({ reinterpret_cast<const char*>(file->data()), file->size() });
+    return true;
+}
+
+void Map::parse(std::string_view text) {
+    const char* const begin = text.data();
+    const char* const end   = begin + text.size();
     zombieSpawns.clear();
+    playerSpawn = {-1, -1};
+
+    // Rows may differ in length, so size the grid from a first pass that
+    // only looks for line breaks
+    std::size_t rows = 0, cols = 0;
+    for (const char* p = begin; p < end; ++rows)
+        cols = std::max(cols, lineLength(p, end, p));
+    walls.resize((int)cols, (int)rows);
+
+    // Second pass: 64 characters at a time straight into the row's words.
+    // Chunks that would read past the end of the text go through a copy.
     int y = 0;
-    std::string line;
-    while (std::getline(in, line)) {
-        for (int x = 0; x < (int)line.size(); ++x) {
-            if (line[x] == 'P') playerSpawn = {x, y};
-            if (line[x] == 'Z') zombieSpawns.push_back({x, y});
+    for (const char* p = begin; p < end; ++y) {
+        const char* line = p;
+        const std::size_t len = lineLength(p, end, p);
+        std::uint64_t* out = walls.row(y);
+
+        for (std::size_t i = 0; i < len; i += 64) {
+            const std::size_t n = std::min<std::size_t>(64, len - i);
+            const unsigned char* src = reinterpret_cast<const unsigned char*>(line + i);
+            unsigned char tail[64];
+            if (std::size_t(end - (line + i)) < 64) {
+                std::memset(tail, 0, sizeof(tail));
+                std::memcpy(tail, src, n);
+                src = tail;
+            }
+
+            std::uint64_t markers;
+            const std::uint64_t keep = n == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+            out[i >> 6] = classify64(src, markers) & keep;
+
+            // Spawns are rare; visit only the marked characters
+            for (markers &= keep; markers; markers &= markers - 1) {
+                const int x = int(i) + std::countr_zero(markers);
+                if (line[x] == 'P') playerSpawn = {x, y};
+                else                zombieSpawns.push_back({x, y});
+            }
         }
-        grid.push_back(line);
-        ++y;
     }
-    return true;
 }
 
-bool Map::isWall(int x, int y) const {
-    if (y < 0 || y >= (int)grid.size()) return false;
-    if (x < 0 || x >= (int)grid[y].size()) return false;
-    return grid[y][x] == '#';
+bool Map::setWall(int x, int y, bool wall) {
+    if (x < 0 || x >= width() || y < 0 || y >= height()) return false;
+    walls.set(x, y, wall);
+    return true;
 }
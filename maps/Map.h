@@ -1,13 +1,35 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cmath>
 #include <glm/glm.hpp>
 
+#include "OccupancyGrid.h"
+
 struct Map {
-    std::vector<std::string> grid;
+    OccupancyGrid walls;   // 1 bit per cell, set = wall
     glm::ivec2 playerSpawn = {-1, -1};
     std::vector<glm::ivec2> zombieSpawns;
 
+    // Text (.txt) or binary (.t3vm, see MapFormat.h) map, picked by content
     bool load(const std::string& filename);
-    bool isWall(int x, int y) const;
+    // Parse a text map already in memory: '#' is wall, 'P' the player spawn,
+    // 'Z' a zombie spawn, anything else floor; one row per line
+    void parse(std::string_view text);
+    bool isWall(int x, int y) const { return walls.get(x, y); }
+    // Change one cell; returns false when (x, y) is outside the map
+    bool setWall(int x, int y, bool wall);
+
+    // Map size in cells (width is the longest row; shorter rows are floor)
+    int width() const  { return walls.width(); }
+    int height() const { return walls.height(); }
+
+    // Cell (x, y) <-> world XZ. Row 0 is the far edge: world z grows as y shrinks.
+    glm::vec3 cellCenter(int x, int y, float worldY = 0.0f) const {
+        return { x + 0.5f, worldY, (height() - 1 - y) + 0.5f };
+    }
+    glm::ivec2 worldToCell(const glm::vec3& p) const {
+        return { (int)std::floor(p.x), height() - 1 - (int)std::floor(p.z) };
+    }
 };
@@ -0,0 +1,145 @@
+#include "MapFormat.h"
+#include "MappedFile.h"
+#include "Map.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', '3', 'V', 'M' };
+
+std::uint64_t alignUp(std::uint64_t v, std::uint64_t a) { return (v + a - 1) / a * a; }
+
+} // namespace
+
+bool isBinaryMap(const unsigned char* data, std::size_t size) {
+    return size >= 4 && std::memcmp(data, kMagic, 4) == 0;
+}
+
+bool saveBinaryMap(const Map& map, const std::string& path) {
+    static_assert(std::endian::native == std::endian::little, "map files are little-endian");
+
+    MapFileHeader hdr{};
+    std::memcpy(hdr.magic, kMagic, 4);
+    hdr.version     = kMapFormatVersion;
+    hdr.width       = (std::uint32_t)map.width();
+    hdr.height      = (std::uint32_t)map.height();
+    hdr.wordsPerRow = (std::uint32_t)map.walls.wordsPerRow();
+    hdr.rowCount    = (std::uint32_t)OccupancyGrid::paddedRowsFor(map.height());
+    hdr.playerX     = map.playerSpawn.x;
+    hdr.playerY     = map.playerSpawn.y;
+    hdr.zombieCount = (std::uint32_t)map.zombieSpawns.size();
+
+    const std::uint64_t occBytes = map.walls.wordCount() * sizeof(std::uint64_t);
+    hdr.occupancyOffset = alignUp(sizeof(MapFileHeader), 64);
+    hdr.spawnOffset     = hdr.occupancyOffset + occBytes;
+    hdr.fileSize        = hdr.spawnOffset + std::uint64_t(hdr.zombieCount) * 8;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    std::vector<char> pad(hdr.occupancyOffset - sizeof(hdr), 0);
+    out.write(pad.data(), (std::streamsize)pad.size());
+    out.write(reinterpret_cast<const char*>(map.walls.data()), (std::streamsize)occBytes);
+    for (const glm::ivec2& z : map.zombieSpawns) {
+        std::int32_t xy[2] = { z.x, z.y };
+        out.write(reinterpret_cast<const char*>(xy), sizeof(xy));
+    }
+    return (bool)out;
+}
+
+bool saveTextMap(const Map& map, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    // Spawns bucketed by row, so each row is written in one pass
+    std::vector<std::size_t> first(std::size_t(map.height()) + 1, 0);
+    for (const glm::ivec2& z : map.zombieSpawns)
+        if ((unsigned)z.y < (unsigned)map.height()) ++first[z.y + 1];
+    for (std::size_t y = 0; y < std::size_t(map.height()); ++y) first[y + 1] += first[y];
+    std::vector<int> spawnX(first.back());
+    std::vector<std::size_t> fill(first.begin(), first.end() - 1);
+    for (const glm::ivec2& z : map.zombieSpawns)
+        if ((unsigned)z.y < (unsigned)map.height()) spawnX[fill[z.y]++] = z.x;
+
+    std::string line;
+    for (int y = 0; y < map.height(); ++y) {
+        line.assign(std::size_t(map.width()), '.');
+        const std::uint64_t* row = map.walls.row(y);
+        for (std::size_t k = 0; k < map.walls.wordsPerRow(); ++k)
+            for (std::uint64_t bits = row[k]; bits; bits &= bits - 1)
+                line[k * 64 + std::countr_zero(bits)] = '#';
+        for (std::size_t i = first[y]; i < first[y + 1]; ++i)
+            if ((unsigned)spawnX[i] < (unsigned)map.width()) line[spawnX[i]] = 'Z';
+        if (map.playerSpawn.y == y && (unsigned)map.playerSpawn.x < (unsigned)map.width())
+            line[map.playerSpawn.x] = 'P';
+        line += '\n';
+        out.write(line.data(), (std::streamsize)line.size());
+    }
+    return (bool)out;
+}
+
+bool loadBinaryMap(Map& map, std::shared_ptr<const MappedFile> file, const std::string& path) {
+    if (!file || file->size() < sizeof(MapFileHeader)) return false;
+
+    MapFileHeader hdr;
+    std::memcpy(&hdr, file->data(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, kMagic, 4) != 0 || hdr.version != kMapFormatVersion) {
+        std::cerr << "Unsupported map file: " << path << std::endl;
+        return false;
+    }
+    // Offsets and counts come from the file: compare each against the room
+    // left after its offset, so no sum can wrap
+    const std::uint64_t size  = file->size();
+    const std::uint64_t words = std::uint64_t(hdr.wordsPerRow) * hdr.rowCount;
+    if (hdr.width > 0x7fffffffu || hdr.height > 0x7fffffffu ||
+        hdr.wordsPerRow != OccupancyGrid::strideFor((int)hdr.width) ||
+        hdr.rowCount != OccupancyGrid::paddedRowsFor((int)hdr.height) ||
+        hdr.fileSize != size ||
+        hdr.occupancyOffset % 64 != 0 ||
+        hdr.occupancyOffset > size || words > (size - hdr.occupancyOffset) / sizeof(std::uint64_t) ||
+        hdr.spawnOffset > size || hdr.zombieCount > (size - hdr.spawnOffset) / 8) {
+        std::cerr << "Corrupt map file: " << path << std::endl;
+        return false;
+    }
+
+    // Cells past the width or height must be clear, or they would count as
+    // walls in whole-word reads. This reads each row's last word (and the
+    // padding rows), not the whole section.
+    const auto* occupancy = reinterpret_cast<const std::uint64_t*>(file->data() + hdr.occupancyOffset);
+    const std::uint32_t used = hdr.width % 64;
+    const std::uint64_t lastWordPad = hdr.width == 0 ? ~std::uint64_t(0)
+                                    : used ? ~std::uint64_t(0) << used : 0;
+    for (std::uint32_t y = 0; y < hdr.rowCount; ++y) {
+        const std::uint64_t* row = occupancy + std::size_t(y) * hdr.wordsPerRow;
+        bool padded;
+        if (y < hdr.height) {
+            padded = (row[hdr.wordsPerRow - 1] & lastWordPad) != 0;
+        } else {
+            padded = false;
+            for (std::uint32_t k = 0; k < hdr.wordsPerRow && !padded; ++k) padded = row[k] != 0;
+        }
+        if (padded) {
+            std::cerr << "Corrupt map file (cells set outside the map): " << path << std::endl;
+            return false;
+        }
+    }
+
+    map.playerSpawn = { hdr.playerX, hdr.playerY };
+    map.zombieSpawns.resize(hdr.zombieCount);
+    for (std::uint32_t i = 0; i < hdr.zombieCount; ++i) {
+        std::int32_t xy[2];
+        std::memcpy(xy, file->data() + hdr.spawnOffset + std::uint64_t(i) * 8, sizeof(xy));
+        map.zombieSpawns[i] = { xy[0], xy[1] };
+    }
+
+    // The grid shares ownership of the mapping, so it stays valid for as
+    // long as any copy of the grid uses it
+    map.walls.adopt(occupancy, (int)hdr.width, (int)hdr.height, std::move(file));
+    return true;
+}
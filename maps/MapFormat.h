@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct Map;
+class MappedFile;
+
+// Binary map file (".t3vm"), little-endian:
+//
+//   MapFileHeader                      64 bytes
+//   occupancy words                    at occupancyOffset (64-byte aligned),
+//                                      OccupancyGrid layout: wordsPerRow words
+//                                      per row, rowCount rows (height padded
+//                                      to a multiple of 8)
+//   zombie spawns                      at spawnOffset, zombieCount x (x, y) int32
+//
+// The occupancy section is used in place from a memory mapping, so loading
+// only touches the header and the spawn table.
+struct MapFileHeader {
+    char          magic[4];          // "T3VM"
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t wordsPerRow;
+    std::uint32_t rowCount;
+    std::int32_t  playerX;
+    std::int32_t  playerY;
+    std::uint32_t zombieCount;
+    std::uint32_t reserved;
+    std::uint64_t occupancyOffset;
+    std::uint64_t spawnOffset;
+    std::uint64_t fileSize;
+};
+static_assert(sizeof(MapFileHeader) == 64, "MapFileHeader must stay 64 bytes");
+
+constexpr std::uint32_t kMapFormatVersion = 1;
+
+// Does the data start with the binary map magic?
+bool isBinaryMap(const unsigned char* data, std::size_t size);
+
+bool saveBinaryMap(const Map& map, const std::string& path);
+
+// Write the text format Map::parse reads: '#' wall, '.' floor, 'P' the
+// player spawn, 'Z' zombie spawns, one row per line
+bool saveTextMap(const Map& map, const std::string& path);
+
+// Point map.walls at the occupancy section of an already mapped file
+// (zero-copy; the grid keeps file alive). path is only for messages.
+bool loadBinaryMap(Map& map, std::shared_ptr<const MappedFile> file, const std::string& path);
@@ -0,0 +1,297 @@
+#include "MapGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Extra corridors (beyond the spanning tree) between neighbouring rooms
+constexpr float kRoomLoopChance = 0.1f;
+// Maze passages carried down to the next row
+constexpr float kMazeDownChance = 0.4f;
+// No zombie spawns within this many cells (Chebyshev) of the player
+constexpr int kPlayerClearance = 8;
+
+// SplitMix64 (Steele, Lea & Flood 2014): tiny state, same stream everywhere
+struct Rng {
+    std::uint64_t state;
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, n) for n >= 1 (multiply-shift; bias below 2^-32)
+    std::uint32_t below(std::uint32_t n) {
+        return std::uint32_t(((next() >> 32) * n) >> 32);
+    }
+    bool chance(float p) {
+        return float(next() >> 40) < p * float(1 << 24);
+    }
+};
+
+// Union-find over dense ids, path halving
+std::uint32_t findRoot(std::vector<std::uint32_t>& parent, std::uint32_t i) {
+    while (parent[i] != i) i = parent[i] = parent[parent[i]];
+    return i;
+}
+
+// Mark cells [x, x + n) open in a row mask
+void openCells(std::vector<std::uint64_t>& open, int x, int n) {
+    for (int i = x; i < x + n; ++i) open[std::size_t(i) >> 6] |= std::uint64_t(1) << (i & 63);
+}
+
+// Clear the open cells of rows [y0, y1)
+void carveRows(OccupancyGrid& walls, const std::vector<std::uint64_t>& open, int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+        std::uint64_t* row = walls.row(y);
+        for (std::size_t k = 0; k < open.size(); ++k) row[k] &= ~open[k];
+    }
+}
+
+// Eller's algorithm: one row of maze cells at a time, so memory is O(width)
+// however tall the maze. Cells are corridor x corridor squares on a pitch of
+// corridor + 1, with one-cell walls between them. Each row of cells is
+// carved as a bit mask, a word at a time.
+void generateMaze(Map& map, int corridor, Rng& rng) {
+    const int W = map.width(), H = map.height();
+    const int pitch = corridor + 1;
+    const int mx = (W - 1) / pitch, my = (H - 1) / pitch;
+    map.walls.fillRect(0, 0, W, H, true);
+
+    // Set label of each cell in the current row; labels stay in [0, mx)
+    std::vector<std::uint32_t> label(mx), parent(mx), members(mx), pick(mx);
+    std::vector<std::uint8_t>  down(mx), hasDown(mx), used(mx);
+    std::vector<std::uint32_t> freeIds;
+    std::vector<std::uint64_t> cells(map.walls.wordsPerRow()), passages(map.walls.wordsPerRow());
+    for (int i = 0; i < mx; ++i) label[i] = std::uint32_t(i);
+
+    for (int j = 0; j < my; ++j) {
+        const int y0 = 1 + j * pitch;
+        const bool last = j == my - 1;
+        std::fill(cells.begin(), cells.end(), 0);
+        std::fill(passages.begin(), passages.end(), 0);
+        for (int i = 0; i < mx; ++i) {
+            parent[i] = std::uint32_t(i);
+            openCells(cells, 1 + i * pitch, corridor);
+        }
+
+        // Join neighbours in different sets: at random, or all of them on the
+        // last row so the maze ends connected
+        for (int i = 0; i + 1 < mx; ++i) {
+            const std::uint32_t a = findRoot(parent, label[i]), b = findRoot(parent, label[i + 1]);
+            if (a == b || !(last || rng.chance(0.5f))) continue;
+            parent[b] = a;
+            openCells(cells, 1 + i * pitch + corridor, 1);
+        }
+        carveRows(map.walls, cells, y0, y0 + corridor);
+        if (last) break;
+        for (int i = 0; i < mx; ++i) label[i] = findRoot(parent, label[i]);
+
+        // Every set continues down at least once: random cells, then one
+        // member (picked uniformly as they go by) of each set that has none
+        std::fill(members.begin(), members.end(), 0);
+        std::fill(hasDown.begin(), hasDown.end(), 0);
+        for (int i = 0; i < mx; ++i) {
+            const std::uint32_t id = label[i];
+            if (rng.below(++members[id]) == 0) pick[id] = std::uint32_t(i);
+            down[i] = rng.chance(kMazeDownChance);
+            hasDown[id] |= down[i];
+        }
+        for (int i = 0; i < mx; ++i) {
+            const std::uint32_t id = label[i];
+            if (!hasDown[id] && pick[id] == std::uint32_t(i)) down[i] = hasDown[id] = 1;
+        }
+
+        // Cells below a passage keep their set; the rest get unused labels
+        std::fill(used.begin(), used.end(), 0);
+        for (int i = 0; i < mx; ++i) {
+            if (!down[i]) continue;
+            used[label[i]] = 1;
+            openCells(passages, 1 + i * pitch, corridor);
+        }
+        carveRows(map.walls, passages, y0 + corridor, y0 + pitch);
+        freeIds.clear();
+        for (int id = 0; id < mx; ++id)
+            if (!used[id]) freeIds.push_back(std::uint32_t(id));
+        for (int i = 0; i < mx; ++i) {
+            if (down[i]) continue;
+            label[i] = freeIds.back();
+            freeIds.pop_back();
+        }
+    }
+}
+
+// Rooms on a grid of sectors, one room (or a corridor junction) per sector.
+// Neighbouring sectors are joined along a random spanning tree (Kruskal over
+// shuffled edges), plus a few extra links for loops. Corridors are L-shaped
+// and stay inside the two sectors they join.
+void generateRooms(Map& map, const MapGenSettings& s, Rng& rng) {
+    const int W = map.width(), H = map.height();
+    const int roomMax = std::clamp(s.roomMax, 1, std::min(W, H) - 4);
+    const int roomMin = std::clamp(s.roomMin, 1, roomMax);
+    const int corridor = std::clamp(s.corridorWidth, 1, roomMin);
+    const int S = roomMax + 2;                 // sector side: room plus a wall each side
+    const int nx = std::max(1, (W - 2) / S), ny = std::max(1, (H - 2) / S);
+    map.walls.fillRect(0, 0, W, H, true);
+
+    // Corner of a corridor-sized square inside each sector's room
+    std::vector<glm::ivec2> anchor(std::size_t(nx) * ny);
+    for (int sy = 0; sy < ny; ++sy) {
+        for (int sx = 0; sx < nx; ++sx) {
+            const bool room = rng.chance(0.75f);
+            const int rw = room ? roomMin + int(rng.below(std::uint32_t(roomMax - roomMin + 1))) : corridor;
+            const int rh = room ? roomMin + int(rng.below(std::uint32_t(roomMax - roomMin + 1))) : corridor;
+            const int rx = 2 + sx * S + int(rng.below(std::uint32_t(roomMax - rw + 1)));
+            const int ry = 2 + sy * S + int(rng.below(std::uint32_t(roomMax - rh + 1)));
+            map.walls.fillRect(rx, ry, rx + rw, ry + rh, false);
+            anchor[std::size_t(sy) * nx + sx] = { rx + int(rng.below(std::uint32_t(rw - corridor + 1))),
+                                                  ry + int(rng.below(std::uint32_t(rh - corridor + 1))) };
+        }
+    }
+
+    // Edge e joins sector e / 2 to its right (e even) or lower (e odd) neighbour
+    std::vector<std::uint32_t> edges;
+    edges.reserve(std::size_t(nx) * ny * 2);
+    for (int sy = 0; sy < ny; ++sy) {
+        for (int sx = 0; sx < nx; ++sx) {
+            const std::uint32_t e = std::uint32_t(sy * nx + sx) * 2;
+            if (sx + 1 < nx) edges.push_back(e);
+            if (sy + 1 < ny) edges.push_back(e + 1);
+        }
+    }
+    for (std::size_t i = edges.size(); i > 1; --i)
+        std::swap(edges[i - 1], edges[rng.below(std::uint32_t(i))]);
+
+    std::vector<std::uint32_t> parent(std::size_t(nx) * ny);
+    for (std::size_t i = 0; i < parent.size(); ++i) parent[i] = std::uint32_t(i);
+    for (std::uint32_t e : edges) {
+        const std::uint32_t a = e / 2, b = e & 1 ? a + std::uint32_t(nx) : a + 1;
+        const std::uint32_t ra = findRoot(parent, a), rb = findRoot(parent, b);
+        if (ra == rb && !rng.chance(kRoomLoopChance)) continue;
+        parent[rb] = ra;
+
+        glm::ivec2 p = anchor[a], q = anchor[b];
+        if (rng.chance(0.5f)) std::swap(p, q);   // which end the bend is at
+        map.walls.fillRect(std::min(p.x, q.x), p.y, std::max(p.x, q.x) + corridor, p.y + corridor, false);
+        map.walls.fillRect(q.x, std::min(p.y, q.y), q.x + corridor, std::max(p.y, q.y) + corridor, false);
+    }
+}
+
+// Border walls, 1..8-cell blocks covering about obstacleDensity of the map,
+// and long walls broken by corridor-wide gaps
+void generateArena(Map& map, const MapGenSettings& s, Rng& rng) {
+    const int W = map.width(), H = map.height();
+    const int gap = std::max(s.corridorWidth, 1);
+    map.walls.fillRect(0, 0, W, 1, true);
+    map.walls.fillRect(0, H - 1, W, H, true);
+    map.walls.fillRect(0, 0, 1, H, true);
+    map.walls.fillRect(W - 1, 0, W, H, true);
+
+    // 20.25 is the mean area of a block with sides uniform in 1..8
+    const double density = std::clamp(double(s.obstacleDensity), 0.0, 1.0);
+    const std::size_t blocks = std::size_t(double(W) * H * density / 20.25);
+    for (std::size_t i = 0; i < blocks; ++i) {
+        const int x = 1 + int(rng.below(std::uint32_t(W - 2))), y = 1 + int(rng.below(std::uint32_t(H - 2)));
+        const int bw = 1 + int(rng.below(8)), bh = 1 + int(rng.below(8));
+        map.walls.fillRect(x, y, x + bw, y + bh, true);
+    }
+
+    const int longWalls = (W + H) / 32;
+    for (int i = 0; i < longWalls; ++i) {
+        const bool horizontal = rng.chance(0.5f);
+        const int span = horizontal ? W : H, across = horizontal ? H : W;
+        const int at = int(rng.below(std::uint32_t(across)));
+        const int from = int(rng.below(std::uint32_t(span)));
+        const int end = std::min(span, from + span / 4 + int(rng.below(std::uint32_t(span / 2 + 1))));
+        for (int j = from; j < end; ) {
+            const int run = std::min(end, j + 8 + int(rng.below(120)));
+            if (horizontal) map.walls.fillRect(j, at, run, at + 1, true);
+            else            map.walls.fillRect(at, j, at + 1, run, true);
+            j = run + gap;
+        }
+    }
+}
+
+// Player on a random floor cell, zombies on distinct floor cells outside
+// the player's clearance square
+void placeSpawns(Map& map, float zombieDensity, Rng& rng) {
+    const int W = map.width(), H = map.height();
+    const std::size_t floor = std::size_t(W) * H - map.walls.count();
+    if (floor == 0) return;
+
+    auto randomCell = [&] {
+        return glm::ivec2(int(rng.below(std::uint32_t(W))), int(rng.below(std::uint32_t(H))));
+    };
+    for (int tries = 0; tries < 4096 && map.playerSpawn.x < 0; ++tries) {
+        const glm::ivec2 c = randomCell();
+        if (!map.isWall(c.x, c.y)) map.playerSpawn = c;
+    }
+    for (int y = 0; y < H && map.playerSpawn.x < 0; ++y)   // nearly solid map
+        for (int x = 0; x < W && map.playerSpawn.x < 0; ++x)
+            if (!map.isWall(x, y)) map.playerSpawn = { x, y };
+
+    OccupancyGrid taken = map.walls;   // plus the clearance square and spawns so far
+    const glm::ivec2 p = map.playerSpawn;
+    taken.fillRect(p.x - kPlayerClearance, p.y - kPlayerClearance,
+                   p.x + kPlayerClearance + 1, p.y + kPlayerClearance + 1, true);
+
+    const double wanted = std::clamp(double(zombieDensity), 0.0, 1.0) * double(floor);
+    const std::size_t target = std::min(std::size_t(std::llround(wanted)),
+                                        std::size_t(W) * H - taken.count());
+    map.zombieSpawns.reserve(target);
+    // Rejection sampling; give up early on maps packed with spawns
+    for (std::size_t tries = 0; map.zombieSpawns.size() < target && tries < target * 64; ++tries) {
+        const glm::ivec2 c = randomCell();
+        if (taken.get(c.x, c.y)) continue;
+        taken.set(c.x, c.y, true);
+        map.zombieSpawns.push_back(c);
+    }
+}
+
+} // namespace
+
+Map generateMap(const MapGenSettings& settings) {
+    Map map;
+    const int W = std::clamp(settings.width, MapGenSettings::kMinSize, MapGenSettings::kMaxSize);
+    const int H = std::clamp(settings.height, MapGenSettings::kMinSize, MapGenSettings::kMaxSize);
+    map.walls.resize(W, H);
+
+    // The style is mixed in so each style gets its own stream for a seed
+    Rng rng{ settings.seed ^ (std::uint64_t(settings.style) << 56) };
+    switch (settings.style) {
+    case MapStyle::Maze:
+        generateMaze(map, std::clamp(settings.corridorWidth, 1, std::min(W, H) - 2), rng);
+        break;
+    case MapStyle::Rooms:
+        generateRooms(map, settings, rng);
+        break;
+    case MapStyle::Arena:
+        generateArena(map, settings, rng);
+        break;
+    }
+    placeSpawns(map, settings.zombieDensity, rng);
+    return map;
+}
+
+bool parseMapStyle(std::string_view name, MapStyle& style) {
+    for (MapStyle s : { MapStyle::Maze, MapStyle::Rooms, MapStyle::Arena }) {
+        if (name == mapStyleName(s)) {
+            style = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* mapStyleName(MapStyle style) {
+    switch (style) {
+    case MapStyle::Maze:  return "maze";
+    case MapStyle::Rooms: return "rooms";
+    case MapStyle::Arena: return "arena";
+    }
+    return "unknown";
+}
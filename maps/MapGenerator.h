@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+#include "Map.h"
+
+enum class MapStyle {
+    Maze,    // perfect maze: exactly one route between any two cells
+    Rooms,   // rectangular rooms joined by corridors, with a few loops
+    Arena,   // open ground scattered with wall blocks and broken walls
+};
+
+// Everything a generated map depends on. The same settings give the same map
+// on every platform and standard library: randomness comes from a fixed
+// SplitMix64 stream, never from <random> distributions.
+struct MapGenSettings {
+    MapStyle      style  = MapStyle::Rooms;
+    int           width  = 256;        // clamped to [kMinSize, kMaxSize]
+    int           height = 256;
+    std::uint64_t seed   = 1;
+
+    float zombieDensity = 0.002f;      // zombie spawns per floor cell
+    int   corridorWidth = 1;           // maze passages and room corridors, in cells
+    int   roomMin = 4, roomMax = 12;   // room sides (Rooms)
+    float obstacleDensity = 0.1f;      // share of cells under blocks (Arena)
+
+    static constexpr int kMinSize = 8;
+    static constexpr int kMaxSize = 16384;
+};
+
+// Build a map. The outer edge is always wall. The player spawns on a random
+// floor cell, zombies on distinct floor cells away from it. Maze and Rooms
+// maps are fully connected; Arena blocks may close off small pockets.
+Map generateMap(const MapGenSettings& settings);
+
+// "maze", "rooms", "arena"; false for anything else
+bool parseMapStyle(std::string_view name, MapStyle& style);
+const char* mapStyleName(MapStyle style);
@@ -0,0 +1,239 @@
+#include "MapRegions.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+std::uint32_t findRoot(std::vector<std::uint32_t>& parent, std::uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];   // path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// The 8 cells around a cell, in ring order so consecutive entries are
+// 4-neighbours of each other; even entries are the cell's own 4-neighbours
+constexpr int kRingX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+constexpr int kRingY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+} // namespace
+
+void MapRegions::build(const Map& map) {
+    w = map.width();
+    h = map.height();
+    const std::size_t cells = std::size_t(w) * h;
+    label.assign(cells, kNone);
+    sizes.clear();
+    freeIds.clear();
+    stamp.clear();
+
+    // Union each floor cell with its floor neighbours to the left and above.
+    // Roots are always the lower index, so a root is seen before its cells.
+    std::vector<std::uint32_t> parent(cells);
+    std::iota(parent.begin(), parent.end(), 0u);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (map.isWall(x, y)) continue;
+            const std::uint32_t i = std::uint32_t(std::size_t(y) * w + x);
+            if (x > 0 && !map.isWall(x - 1, y)) {
+                std::uint32_t a = findRoot(parent, i - 1), b = findRoot(parent, i);
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+            if (y > 0 && !map.isWall(x, y - 1)) {
+                std::uint32_t a = findRoot(parent, i - w), b = findRoot(parent, i);
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    // Flatten to dense region ids
+    for (std::size_t i = 0; i < cells; ++i) {
+        if (map.isWall(int(i % w), int(i / w))) continue;
+        const std::uint32_t root = findRoot(parent, std::uint32_t(i));
+        if (root == i) {
+            label[i] = std::uint32_t(sizes.size());
+            sizes.push_back(0);
+        } else {
+            label[i] = label[root];
+        }
+        ++sizes[label[i]];
+    }
+}
+
+std::uint32_t MapRegions::newRegion() {
+    if (!freeIds.empty()) {
+        std::uint32_t id = freeIds.back();
+        freeIds.pop_back();
+        return id;
+    }
+    sizes.push_back(0);
+    return std::uint32_t(sizes.size() - 1);
+}
+
+void MapRegions::releaseRegion(std::uint32_t id) {
+    sizes[id] = 0;
+    freeIds.push_back(id);
+}
+
+// Flood cells labelled from, starting at seed, over to to
+void MapRegions::relabel(std::size_t seed, std::uint32_t from, std::uint32_t to) {
+    std::vector<std::size_t> stack{ seed };
+    label[seed] = to;
+    while (!stack.empty()) {
+        const std::size_t c = stack.back();
+        stack.pop_back();
+        const int x = int(c % w), y = int(c / w);
+        const std::size_t nbr[4] = { c - 1, c + 1, c - w, c + w };
+        const bool inside[4] = { x > 0, x + 1 < w, y > 0, y + 1 < h };
+        for (int k = 0; k < 4; ++k) {
+            if (inside[k] && label[nbr[k]] == from) {
+                label[nbr[k]] = to;
+                stack.push_back(nbr[k]);
+            }
+        }
+    }
+}
+
+void MapRegions::updateCell(const Map& map, int x, int y) {
+    if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return;
+    const std::size_t c = std::size_t(y) * w + x;
+    const bool wall = map.isWall(x, y);
+    if (wall == (label[c] == kNone)) return;
+
+    if (!wall) {
+        // New floor joins every region it touches: keep the largest and
+        // relabel the others into it
+        std::uint32_t ids[4];
+        std::size_t seeds[4];
+        int n = 0;
+        for (int k = 0; k < 8; k += 2) {
+            const int nx = x + kRingX[k], ny = y + kRingY[k];
+            const std::uint32_t r = regionOf(nx, ny);
+            if (r == kNone || std::find(ids, ids + n, r) != ids + n) continue;
+            ids[n] = r;
+            seeds[n++] = std::size_t(ny) * w + nx;
+        }
+        if (n == 0) {
+            label[c] = newRegion();
+            sizes[label[c]] = 1;
+            return;
+        }
+        int keep = 0;
+        for (int i = 1; i < n; ++i)
+            if (sizes[ids[i]] > sizes[ids[keep]]) keep = i;
+        label[c] = ids[keep];
+        ++sizes[ids[keep]];
+        for (int i = 0; i < n; ++i) {
+            if (i == keep) continue;
+            sizes[ids[keep]] += sizes[ids[i]];
+            relabel(seeds[i], ids[i], ids[keep]);
+            releaseRegion(ids[i]);
+        }
+        return;
+    }
+
+    // New wall: the region can only split if its floor neighbours are not
+    // already joined around the ring of 8 cells. Take one seed per run of
+    // floor cells on the ring that contains a 4-neighbour.
+    const std::uint32_t region = label[c];
+    label[c] = kNone;
+    if (--sizes[region] == 0) {
+        releaseRegion(region);
+        return;
+    }
+
+    bool floor[8];
+    int start = -1;
+    for (int k = 0; k < 8; ++k) {
+        floor[k] = regionOf(x + kRingX[k], y + kRingY[k]) != kNone;
+        if (!floor[k]) start = k;
+    }
+    if (start < 0) return;   // ring all floor: still one region
+
+    std::vector<std::size_t> seeds;
+    bool runHasSeed = false;
+    for (int i = 1; i <= 8; ++i) {
+        const int k = (start + i) & 7;
+        if (!floor[k]) { runHasSeed = false; continue; }
+        if ((k & 1) == 0 && !runHasSeed) {
+            seeds.push_back(std::size_t(y + kRingY[k]) * w + (x + kRingX[k]));
+            runHasSeed = true;
+        }
+    }
+    if (seeds.size() > 1) split(region, seeds);
+}
+
+// Grow one search per seed in lockstep. Searches that meet are merged; a
+// search that runs dry without meeting the others has found a separate
+// piece and takes a new id. The last piece standing keeps the old id, so
+// the work is bounded by the smaller pieces, not the whole region.
+void MapRegions::split(std::uint32_t region, const std::vector<std::size_t>& seeds) {
+    const std::uint32_t k = std::uint32_t(seeds.size());
+    if (stamp.size() != label.size() || stampBase > ~std::uint32_t(0) - 8) {
+        stamp.assign(label.size(), 0);
+        stampBase = 0;
+    }
+    stampBase += 4;   // at most 4 seeds; stamps below the base are stale
+
+    struct Search {
+        std::vector<std::size_t> cells;   // every cell reached, in BFS order
+        std::size_t              head = 0;
+        bool                     active = true;
+    };
+    std::vector<Search> searches(k);
+    std::vector<std::uint32_t> group(k);   // search -> search that absorbed it
+    for (std::uint32_t i = 0; i < k; ++i) {
+        group[i] = i;
+        searches[i].cells.push_back(seeds[i]);
+        stamp[seeds[i]] = stampBase + i;
+    }
+    auto groupOf = [&](std::uint32_t s) {
+        while (group[s] != s) s = group[s];
+        return s;
+    };
+
+    std::uint32_t active = k;
+    while (active > 1) {
+        for (std::uint32_t i = 0; i < k && active > 1; ++i) {
+            Search& s = searches[i];
+            if (!s.active) continue;
+            if (s.head == s.cells.size()) {
+                // Closed piece: give it its own region
+                const std::uint32_t id = newRegion();
+                for (std::size_t cell : s.cells) label[cell] = id;
+                sizes[id] = s.cells.size();
+                sizes[region] -= s.cells.size();
+                s.active = false;
+                --active;
+                continue;
+            }
+
+            const std::size_t c = s.cells[s.head++];
+            const int x = int(c % w), y = int(c / w);
+            const std::size_t nbr[4] = { c - 1, c + 1, c - w, c + w };
+            const bool inside[4] = { x > 0, x + 1 < w, y > 0, y + 1 < h };
+            for (int n = 0; n < 4; ++n) {
+                if (!inside[n] || label[nbr[n]] != region) continue;
+                const std::uint32_t st = stamp[nbr[n]];
+                if (st < stampBase || st >= stampBase + 4) {
+                    stamp[nbr[n]] = stampBase + i;
+                    s.cells.push_back(nbr[n]);
+                    continue;
+                }
+                const std::uint32_t other = groupOf(st - stampBase);
+                if (other == i) continue;
+                // Met another search: one piece after all. Hand our cells over.
+                Search& o = searches[other];
+                o.cells.insert(o.cells.end(), s.cells.begin(), s.cells.end());
+                s.cells.clear();
+                s.head = 0;
+                s.active = false;
+                group[i] = other;
+                --active;
+                break;
+            }
+        }
+    }
+}
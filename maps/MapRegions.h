@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+// Connected floor regions of a map (4-connected: a sphere cannot squeeze
+// between two walls that touch at a corner). Every floor cell stores its
+// region id, so reachability is two loads and a compare.
+//
+// Built with a union-find pass at load time, then kept current cell by cell:
+// removing a wall joins the regions around it, adding one may split its
+// region. Either way only the smaller side is relabelled.
+class MapRegions {
+public:
+    static constexpr std::uint32_t kNone = ~std::uint32_t(0);
+
+    void build(const Map& map);
+
+    // Refresh after Map::setWall(x, y, ...)
+    void updateCell(const Map& map, int x, int y);
+
+    // Region of a floor cell; kNone for walls and cells outside the map
+    std::uint32_t regionOf(int x, int y) const {
+        if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return kNone;
+        return label[std::size_t(y) * w + x];
+    }
+
+    // Can something walk from cell a to cell b?
+    bool sameRegion(glm::ivec2 a, glm::ivec2 b) const {
+        std::uint32_t ra = regionOf(a.x, a.y);
+        return ra != kNone && ra == regionOf(b.x, b.y);
+    }
+
+    // Floor cells in a region (0 for ids not in use)
+    std::size_t regionSize(std::uint32_t id) const { return id < sizes.size() ? sizes[id] : 0; }
+
+    // Number of regions with at least one cell
+    std::size_t regionCount() const { return sizes.size() - freeIds.size(); }
+
+private:
+    std::uint32_t newRegion();
+    void releaseRegion(std::uint32_t id);
+    void relabel(std::size_t seed, std::uint32_t from, std::uint32_t to);
+    void split(std::uint32_t region, const std::vector<std::size_t>& seeds);
+
+    int w = 0, h = 0;
+    std::vector<std::uint32_t> label;     // per cell, row-major
+    std::vector<std::size_t>   sizes;     // per region id
+    std::vector<std::uint32_t> freeIds;   // ids of emptied regions, reused first
+
+    // Split searches: stamp[cell] - stampBase is the search that reached it
+    std::vector<std::uint32_t> stamp;
+    std::uint32_t              stampBase = 0;
+};
@@ -0,0 +1,135 @@
+#include "OccupancyGrid.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// Words of a 0x0 grid (one per padded row), for moved-from grids
+const std::uint64_t kEmptyWords[8] = {};
+
+} // namespace
+
+OccupancyGrid::OccupancyGrid(const OccupancyGrid& other)
+    : w(other.w), h(other.h), stride(other.stride),
+      owned(other.owned), external(other.external) {
+    bits = external ? other.bits : owned.data();
+}
+
+OccupancyGrid::OccupancyGrid(OccupancyGrid&& other) noexcept
+    : w(other.w), h(other.h), stride(other.stride),
+      owned(std::move(other.owned)), external(std::move(other.external)) {
+    bits = external ? other.bits : owned.data();
+    other.clearNoAlloc();
+}
+
+OccupancyGrid& OccupancyGrid::operator=(const OccupancyGrid& other) {
+    if (this != &other) {
+        OccupancyGrid copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+OccupancyGrid& OccupancyGrid::operator=(OccupancyGrid&& other) noexcept {
+    if (this != &other) {
+        w = other.w;
+        h = other.h;
+        stride = other.stride;
+        owned = std::move(other.owned);
+        external = std::move(other.external);
+        bits = external ? other.bits : owned.data();
+        other.clearNoAlloc();
+    }
+    return *this;
+}
+
+void OccupancyGrid::clearNoAlloc() noexcept {
+    w = h = 0;
+    stride = 1;
+    owned.clear();
+    // The zero block stands in as external words: reads of word 0 keep
+    // working and the first write copies it in. An aliasing shared_ptr
+    // with no owner points at it without allocating a control block.
+    bits = kEmptyWords;
+    external = std::shared_ptr<const void>(std::shared_ptr<const void>(), kEmptyWords);
+}
+
+void OccupancyGrid::resize(int width, int height) {
+    w = std::max(0, width);
+    h = std::max(0, height);
+    stride = strideFor(w);
+    owned.assign(wordCount(), 0);
+    bits = owned.data();
+    external.reset();
+}
+
+void OccupancyGrid::adopt(const std::uint64_t* data, int width, int height,
+                          std::shared_ptr<const void> keepAlive) {
+    w = std::max(0, width);
+    h = std::max(0, height);
+    stride = strideFor(w);
+    owned.clear();
+    owned.shrink_to_fit();
+    bits = data;
+    external = std::move(keepAlive);
+}
+
+void OccupancyGrid::makeOwned() {
+    if (!external) return;
+    owned.assign(bits, bits + wordCount());
+    bits = owned.data();
+    external.reset();
+}
+
+bool OccupancyGrid::anyInRect(int x0, int y0, int x1, int y1) const {
+    x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+    x1 = std::min(x1, w); y1 = std::min(y1, h);
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    const std::size_t k0 = std::size_t(x0) >> 6, k1 = std::size_t(x1 - 1) >> 6;
+    const std::uint64_t first = ~std::uint64_t(0) << (x0 & 63);
+    const std::uint64_t last  = ~std::uint64_t(0) >> (63 - ((x1 - 1) & 63));
+    for (int y = y0; y < y1; ++y) {
+        const std::uint64_t* r = row(y);
+        if (k0 == k1) {
+            if (r[k0] & first & last) return true;
+            continue;
+        }
+        if (r[k0] & first) return true;
+        for (std::size_t k = k0 + 1; k < k1; ++k)
+            if (r[k]) return true;
+        if (r[k1] & last) return true;
+    }
+    return false;
+}
+
+void OccupancyGrid::fillRect(int x0, int y0, int x1, int y1, bool value) {
+    x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+    x1 = std::min(x1, w); y1 = std::min(y1, h);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    const std::size_t k0 = std::size_t(x0) >> 6, k1 = std::size_t(x1 - 1) >> 6;
+    const std::uint64_t first = ~std::uint64_t(0) << (x0 & 63);
+    const std::uint64_t last  = ~std::uint64_t(0) >> (63 - ((x1 - 1) & 63));
+    auto apply = [value](std::uint64_t& word, std::uint64_t mask) {
+        word = value ? (word | mask) : (word & ~mask);
+    };
+    for (int y = y0; y < y1; ++y) {
+        std::uint64_t* r = row(y);
+        if (k0 == k1) {
+            apply(r[k0], first & last);
+            continue;
+        }
+        apply(r[k0], first);
+        for (std::size_t k = k0 + 1; k < k1; ++k) r[k] = value ? ~std::uint64_t(0) : 0;
+        apply(r[k1], last);
+    }
+}
+
+std::size_t OccupancyGrid::count() const {
+    std::size_t n = 0;
+    const std::size_t total = wordCount();
+    for (std::size_t i = 0; i < total; ++i) n += std::popcount(bits[i]);
+    return n;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Dense 1-bit-per-cell grid. Each row is padded to whole 64-cell words and
+// the row count to a multiple of 8, so word and 8x8-block reads never need
+// bounds checks. Cells outside [0, width) x [0, height) read as clear.
+//
+// The words either live in the grid or in external read-only memory (a
+// mapped map file, see adopt()); the first write copies external words in.
+class OccupancyGrid {
+public:
+    OccupancyGrid() = default;
+    OccupancyGrid(const OccupancyGrid& other);
+    OccupancyGrid(OccupancyGrid&& other) noexcept;
+    OccupancyGrid& operator=(const OccupancyGrid& other);
+    OccupancyGrid& operator=(OccupancyGrid&& other) noexcept;
+
+    // Resize to width x height with every cell clear
+    void resize(int width, int height);
+
+    // Use external words laid out as this class stores them (wordsPerRow
+    // words per row, rows padded to a multiple of 8). keepAlive owns them.
+    void adopt(const std::uint64_t* data, int width, int height,
+               std::shared_ptr<const void> keepAlive);
+
+    // Words per row and padded row count for a given size
+    static std::size_t strideFor(int width) { return width > 64 ? (std::size_t(width) + 63) / 64 : 1; }
+    static std::size_t paddedRowsFor(int height) { return height > 8 ? (std::size_t(height) + 7) / 8 * 8 : 8; }
+
+    int width() const  { return w; }
+    int height() const { return h; }
+    std::size_t wordsPerRow() const { return stride; }
+    std::size_t wordCount() const { return stride * paddedRowsFor(h); }
+    const std::uint64_t* data() const { return bits; }
+    std::size_t memoryBytes() const { return owned.size() * sizeof(std::uint64_t); }
+
+    // Branchless: out-of-range coordinates read word 0 with the bit masked off
+    bool get(int x, int y) const {
+        std::uint64_t inside = std::uint64_t((unsigned)x < (unsigned)w) &
+                               std::uint64_t((unsigned)y < (unsigned)h);
+        std::size_t xi = std::size_t(unsigned(x)) * inside;
+        std::size_t yi = std::size_t(unsigned(y)) * inside;
+        return (bits[yi * stride + (xi >> 6)] >> (xi & 63)) & inside;
+    }
+
+    // Writes outside the grid are ignored
+    void set(int x, int y, bool value) {
+        if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return;
+        std::uint64_t& word = row(y)[x >> 6];
+        std::uint64_t bit = std::uint64_t(1) << (x & 63);
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    // Raw words of row y (wordsPerRow() of them; bit i of word k is cell 64k + i)
+    const std::uint64_t* row(int y) const { return bits + std::size_t(y) * stride; }
+    std::uint64_t* row(int y) { makeOwned(); return owned.data() + std::size_t(y) * stride; }
+
+    // Any set cell in the 8x8 block whose top-left cell is (8 bx, 8 by)
+    bool anyInBlock8(int bx, int by) const {
+        if ((unsigned)bx >= (unsigned)((w + 7) / 8) || (unsigned)by >= (unsigned)((h + 7) / 8))
+            return false;
+        const std::uint64_t* p = bits + std::size_t(by) * 8 * stride + (bx >> 3);
+        const int shift = (bx & 7) * 8;
+        std::uint64_t acc = 0;
+        for (int r = 0; r < 8; ++r) acc |= p[r * stride];
+        return (acc >> shift) & 0xff;
+    }
+
+    // Any set cell in [x0, x1) x [y0, y1) (clipped to the grid), a word at a time
+    bool anyInRect(int x0, int y0, int x1, int y1) const;
+
+    // Set or clear every cell in [x0, x1) x [y0, y1) (clipped), a word at a time
+    void fillRect(int x0, int y0, int x1, int y1, bool value);
+
+    // Number of set cells
+    std::size_t count() const;
+
+private:
+    void makeOwned();
+    // Become an empty 0x0 grid without allocating (for moved-from grids)
+    void clearNoAlloc() noexcept;
+
+    int w = 0, h = 0;
+    std::size_t stride = 1;
+    std::vector<std::uint64_t> owned = std::vector<std::uint64_t>(8, 0);
+    const std::uint64_t* bits = owned.data();
+    std::shared_ptr<const void> external;   // keeps adopted words alive
+};
@@ -0,0 +1,251 @@
+#include "PotentiallyVisibleSet.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+// The viewing points sit this far inside the cell's corners, so none lies
+// exactly on a grid line
+constexpr float kCornerInset = 0.05f;
+// Light wedges narrower than this (in slope) are dropped, so light never
+// leaks through the point where two walls meet diagonally
+constexpr float kMinWedge = 1e-5f;
+
+// Marks in the view window; anything else is 0
+constexpr std::uint8_t kSeenFloor = 1;
+constexpr std::uint8_t kSeenWall  = 2;
+
+struct Wedge { float t0, t1; };   // lit slopes, lateral over forward
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(std::uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(std::uint8_t(v));
+}
+
+std::uint64_t getVarint(const std::uint8_t*& p) {
+    std::uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+        const std::uint8_t b = *p++;
+        v |= std::uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// Light a quadrant of the window from one point (shadowcasting). Columns
+// step forward from the point; each keeps the wedges of slope still lit
+// after the walls of the columns before it. A cell is lit when a wedge
+// crosses it. A wall only shadows the columns behind it, so a ray that
+// clips a wall and then a floor cell in the same column lights the floor:
+// the result errs toward seeing too much. cell(u, v) maps quadrant
+// coordinates to the window's mark for a floor cell, or nullptr where the
+// light stops; lit(c, u, v) is called for every floor cell reached.
+// Returns the cells examined.
+template <class Cell, class Lit>
+std::uint64_t sweep(float ou, float ov, int depth, std::vector<Wedge>& wedges, std::vector<Wedge>& next,
+                    Cell&& cell, Lit&& lit) {
+    std::uint64_t examined = 0;
+    wedges.assign(1, Wedge{ -1.0f, 1.0f });
+    const int u0 = (int)std::floor(ou);
+    for (int u = u0; u <= u0 + depth && !wedges.empty(); ++u) {
+        // Forward extent of this column, from the point
+        const float n = std::max(float(u) - ou, 0.0f), f = float(u) + 1 - ou;
+        next.clear();
+        for (const Wedge& wg : wedges) {
+            const float vlo = ov + std::min(wg.t0 * n, wg.t0 * f);
+            const float vhi = ov + std::max(wg.t1 * n, wg.t1 * f);
+            float t = wg.t0;   // start of the wedge still lit past this column
+            for (int v = (int)std::floor(vlo), vEnd = std::max((int)std::ceil(vhi), v + 1); v < vEnd; ++v) {
+                ++examined;
+                std::uint8_t* c = cell(u, v);
+                if (c) {
+                    lit(*c, u, v);
+                    continue;
+                }
+                // Slopes this wall covers, seen from the point
+                const float a = float(v) - ov, b = a + 1;
+                const float b0 = a >= 0 ? a / f : n > 0 ? a / n : -1e30f;
+                const float b1 = b <= 0 ? b / f : n > 0 ? b / n : 1e30f;
+                if (std::min(b0, wg.t1) - t > kMinWedge) next.push_back(Wedge{ t, std::min(b0, wg.t1) });
+                t = std::max(t, b1);
+            }
+            if (wg.t1 - t > kMinWedge) next.push_back(Wedge{ t, wg.t1 });
+        }
+        wedges.swap(next);
+    }
+    return examined;
+}
+
+// Set cells [begin, end) of out, in row-major order
+void setRun(OccupancyGrid& out, std::size_t begin, std::size_t end) {
+    const std::size_t w = std::size_t(out.width());
+    while (begin < end) {
+        const int y = int(begin / w);
+        const std::size_t x0 = begin % w, x1 = std::min(w, x0 + (end - begin));
+        std::uint64_t* row = out.row(y);
+        for (std::size_t x = x0; x < x1; ) {
+            const std::size_t word = x >> 6, bit = x & 63;
+            const std::size_t n = std::min<std::size_t>(64 - bit, x1 - x);
+            const std::uint64_t mask = n == 64 ? ~std::uint64_t(0) : ((std::uint64_t(1) << n) - 1) << bit;
+            row[word] |= mask;
+            x += n;
+        }
+        begin += x1 - x0;
+    }
+}
+
+} // namespace
+
+bool PotentiallyVisibleSet::bake(const Map& map, const Settings& settings, ThreadPool* pool) {
+    w = map.width();
+    h = map.height();
+    runs.clear();
+    offsets.clear();
+    const int R = std::max(settings.maxDistance, 1);
+
+    // The window around the viewing cell holds the view square plus a ring
+    // for the walls bordering it
+    const int span = 2 * R + 3;
+
+    // One stream per cell, built a row at a time
+    std::vector<std::vector<std::uint8_t>>  rowRuns(h);
+    std::vector<std::vector<std::uint32_t>> rowSizes(h);
+    std::atomic<std::uint64_t> examined{ 0 }, bytes{ 0 };
+    std::atomic<bool>          over{ false };
+
+    auto bakeRows = [&](std::size_t begin, std::size_t end) {
+        std::vector<std::uint8_t> seen(std::size_t(span) * span, 0);
+        std::vector<Wedge>        wedges, next;
+        for (int y = int(begin); y < int(end) && !over; ++y) {
+            auto& out = rowRuns[y];
+            auto& sizes = rowSizes[y];
+            sizes.assign(w, 0);
+            std::uint64_t rowExamined = 0;
+            for (int x = 0; x < w; ++x) {
+                if (map.isWall(x, y)) continue;
+
+                // Window cell (0, 0) is map cell (x0, y0). Light stops at
+                // walls, the map's edge and the view square's; the marks
+                // it leaves are kept within [bx0, bx1] x [by0, by1].
+                const int x0 = x - R - 1, y0 = y - R - 1;
+                int bx0 = x, bx1 = x, by0 = y, by1 = y;
+                auto floorAt = [&](int cx, int cy) -> std::uint8_t* {
+                    if (std::abs(cx - x) > R || std::abs(cy - y) > R) return nullptr;
+                    if ((unsigned)cx >= (unsigned)w || (unsigned)cy >= (unsigned)h || map.isWall(cx, cy)) return nullptr;
+                    return &seen[std::size_t(cy - y0) * span + (cx - x0)];
+                };
+
+                // Light from just inside each corner, in all four quadrants;
+                // floor within maxDistance of the cell is seen
+                const int R2 = R * R;
+                auto mark = [&](std::uint8_t& c, int cx, int cy) {
+                    if ((cx - x) * (cx - x) + (cy - y) * (cy - y) > R2) return;
+                    c = kSeenFloor;
+                    bx0 = std::min(bx0, cx);
+                    bx1 = std::max(bx1, cx);
+                    by0 = std::min(by0, cy);
+                    by1 = std::max(by1, cy);
+                };
+                const float corners[4][2] = {
+                    { x + kCornerInset, y + kCornerInset }, { x + 1 - kCornerInset, y + kCornerInset },
+                    { x + kCornerInset, y + 1 - kCornerInset }, { x + 1 - kCornerInset, y + 1 - kCornerInset },
+                };
+                for (const auto& p : corners) {
+                    const float px = p[0], py = p[1];
+                    // +x, -x, +y, -y; u runs forward, v sideways
+                    rowExamined += sweep(px, py, R + 1, wedges, next,
+                        [&](int u, int v) { return floorAt(u, v); },
+                        [&](std::uint8_t& c, int u, int v) { mark(c, u, v); });
+                    rowExamined += sweep(-px, py, R + 1, wedges, next,
+                        [&](int u, int v) { return floorAt(-u - 1, v); },
+                        [&](std::uint8_t& c, int u, int v) { mark(c, -u - 1, v); });
+                    rowExamined += sweep(py, px, R + 1, wedges, next,
+                        [&](int u, int v) { return floorAt(v, u); },
+                        [&](std::uint8_t& c, int u, int v) { mark(c, v, u); });
+                    rowExamined += sweep(-py, px, R + 1, wedges, next,
+                        [&](int u, int v) { return floorAt(v, -u - 1); },
+                        [&](std::uint8_t& c, int u, int v) { mark(c, v, -u - 1); });
+                }
+
+                // Walls next to a seen floor cell show a face to it
+                const int ex0 = std::max(bx0 - 1, 0), ex1 = std::min(bx1 + 1, w - 1);
+                const int ey0 = std::max(by0 - 1, 0), ey1 = std::min(by1 + 1, h - 1);
+                auto markAt = [&](int cx, int cy) -> std::uint8_t& {
+                    return seen[std::size_t(cy - y0) * span + (cx - x0)];
+                };
+                for (int cy = by0; cy <= by1; ++cy) {
+                    for (int cx = bx0; cx <= bx1; ++cx) {
+                        if (markAt(cx, cy) != kSeenFloor) continue;
+                        const int nx[4] = { cx + 1, cx - 1, cx, cx }, ny[4] = { cy, cy, cy + 1, cy - 1 };
+                        for (int k = 0; k < 4; ++k) {
+                            if ((unsigned)nx[k] < (unsigned)w && (unsigned)ny[k] < (unsigned)h && map.isWall(nx[k], ny[k]))
+                                markAt(nx[k], ny[k]) = kSeenWall;
+                        }
+                    }
+                }
+
+                // Run-length encode the marks in map row-major order, and
+                // clear them for the next cell
+                const std::size_t before = out.size();
+                std::size_t pos = 0;
+                for (int cy = ey0; cy <= ey1; ++cy) {
+                    std::uint8_t* r = &markAt(ex0, cy);
+                    for (int i = 0, n = ex1 - ex0 + 1; i < n; ) {
+                        if (!r[i]) { ++i; continue; }
+                        int j = i;
+                        while (j < n && r[j]) r[j++] = 0;
+                        const std::size_t start = std::size_t(cy) * w + ex0 + i;
+                        putVarint(out, start - pos);
+                        putVarint(out, std::size_t(j - i));
+                        pos = start + (j - i);
+                        i = j;
+                    }
+                }
+                sizes[x] = std::uint32_t(out.size() - before);
+            }
+
+            // Give up once either budget is spent; every worker checks
+            // between rows
+            const std::uint64_t e = examined += rowExamined, b = bytes += out.size();
+            if ((settings.maxExamined && e > settings.maxExamined) || (settings.maxBytes && b > settings.maxBytes))
+                over = true;
+        }
+    };
+    if (pool) pool->parallelFor(std::size_t(h), 1, bakeRows);
+    else      bakeRows(0, std::size_t(h));
+    if (over) return false;
+
+    std::size_t total = 0;
+    for (const auto& r : rowRuns) total += r.size();
+    runs.reserve(total);
+    offsets.assign(std::size_t(w) * h + 1, 0);
+    std::size_t cell = 0;
+    for (int y = 0; y < h; ++y) {
+        runs.insert(runs.end(), rowRuns[y].begin(), rowRuns[y].end());
+        for (int x = 0; x < w; ++x, ++cell) offsets[cell + 1] = offsets[cell] + rowSizes[y][x];
+    }
+    return true;
+}
+
+bool PotentiallyVisibleSet::visibleFrom(int x, int y, OccupancyGrid& out) const {
+    if (offsets.empty() || (unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return false;
+    const std::size_t cell = std::size_t(y) * w + x;
+    if (offsets[cell] == offsets[cell + 1]) return false;   // wall
+
+    out.resize(w, h);
+    const std::uint8_t* p   = runs.data() + offsets[cell];
+    const std::uint8_t* end = runs.data() + offsets[cell + 1];
+    std::size_t pos = 0;
+    while (p < end) {
+        pos += getVarint(p);
+        const std::size_t n = getVarint(p);
+        setRun(out, pos, pos + n);
+        pos += n;
+    }
+    return true;
+}
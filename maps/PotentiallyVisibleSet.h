@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+#include "OccupancyGrid.h"
+
+class ThreadPool;
+
+// Cells visible from each floor cell, baked when the map loads. Walls are
+// taller than the eye, so visibility is 2D and limited to a circle of
+// maxDistance cells. Each cell is lit by shadowcasting from just inside its
+// four corners: every floor cell the light reaches is visible, and so is
+// every wall cell next to one of those (its face can be seen). Light that
+// clips a wall corner may reach a cell past it, so the set errs toward
+// drawing more.
+//
+// Each cell's set is a run-length bitset over the map in row-major order.
+// Runs alternate clear/set, start with clear, and are stored as varints.
+// Both the bake time and the size follow how much a cell sees: corridor
+// maps cost tens of bytes per cell, open arenas several hundred, which is
+// what the budgets are for.
+class PotentiallyVisibleSet {
+public:
+    struct Settings {
+        int           maxDistance = 100;   // view circle radius, in cells
+        std::uint64_t maxExamined = 0;     // cells looked at while lighting; 0: no limit
+        std::size_t   maxBytes    = 0;     // encoded size; 0: no limit
+    };
+
+    // pool (optional) spreads the per-cell ray casting over workers.
+    // Returns false, leaving the set empty, once either budget runs out.
+    bool bake(const Map& map, const Settings& settings, ThreadPool* pool = nullptr);
+
+    // Decode the set of (x, y) into out, sized to the map. Returns false
+    // (out untouched) for walls and cells outside the map; draw everything then.
+    bool visibleFrom(int x, int y, OccupancyGrid& out) const;
+
+    bool empty() const { return offsets.empty(); }
+    std::size_t memoryBytes() const {
+        return runs.size() + offsets.size() * sizeof(std::uint64_t);
+    }
+
+private:
+    int w = 0, h = 0;
+    std::vector<std::uint8_t>  runs;      // every cell's varint stream, back to back
+    std::vector<std::uint64_t> offsets;   // w * h + 1 stream bounds; equal for walls
+};
@@ -0,0 +1,44 @@
+#include "WallRects.h"
+
+#include <algorithm>
+
+std::vector<WallRect> mergeWallRects(const Map& map) {
+    return mergeWallRects(map, 0, 0, map.width(), map.height());
+}
+
+std::vector<WallRect> mergeWallRects(const Map& map, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, map.width());
+    y1 = std::min(y1, map.height());
+    if (x0 >= x1 || y0 >= y1) return {};
+
+    const int w = x1 - x0;
+    std::vector<unsigned char> used(std::size_t(w) * (y1 - y0), 0);
+    auto free = [&](int x, int y) {
+        return map.isWall(x, y) && !used[std::size_t(y - y0) * w + (x - x0)];
+    };
+
+    std::vector<WallRect> rects;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            if (!free(x, y)) continue;
+
+            WallRect r{x, y, 1, 1};
+            while (x + r.w < x1 && free(x + r.w, y)) ++r.w;
+            for (bool grow = true; grow && y + r.h < y1; ) {
+                for (int i = 0; i < r.w; ++i) {
+                    if (!free(x + i, y + r.h)) { grow = false; break; }
+                }
+                if (grow) ++r.h;
+            }
+
+            for (int j = 0; j < r.h; ++j)
+                for (int i = 0; i < r.w; ++i)
+                    used[std::size_t(y + j - y0) * w + (x + i - x0)] = 1;
+            rects.push_back(r);
+            x += r.w - 1;
+        }
+    }
+    return rects;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Map.h"
+
+// Axis-aligned block of wall cells: [x, x+w) x [y, y+h) in map cells
+struct WallRect {
+    int x = 0, y = 0;
+    int w = 0, h = 0;
+};
+
+// Greedily cover every wall cell with maximal rectangles: grow a run along
+// the row, then extend it down while the whole run stays wall. Each cell
+// lands in exactly one rect.
+std::vector<WallRect> mergeWallRects(const Map& map);
+
+// Same, limited to cells in [x0, x1) x [y0, y1); rects never cross the
+// region's edges, so neighbouring regions can be merged independently
+std::vector<WallRect> mergeWallRects(const Map& map, int x0, int y0, int x1, int y1);
+
+// World-space bounds of a rect standing on y = 0 with the given height
+inline glm::vec3 wallRectMin(const Map& map, const WallRect& r) {
+    return { (float)r.x, 0.0f, (float)(map.height() - r.y - r.h) };
+}
+inline glm::vec3 wallRectMax(const Map& map, const WallRect& r, float wallHeight) {
+    return { (float)(r.x + r.w), wallHeight, (float)(map.height() - r.y) };
+}
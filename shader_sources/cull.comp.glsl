@@ -0,0 +1,98 @@
+#version 430 core
+
+// One invocation per wall instance: frustum test, then Hi-Z occlusion
+// against last frame's depth. Survivors append their model matrix to
+// uVisible and bump the indirect draw's instance count.
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer Bounds {
+    vec4 bounds[];          // world XZ rect: (x0, z0, x1, z1)
+};
+layout(std430, binding = 1) writeonly buffer Visible {
+    mat4 visible[];
+};
+layout(std430, binding = 2) buffer Command {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+} command;
+
+uniform bool  uFinish;          // single invocation: clamp the count to uCapacity
+uniform uint  uInstanceCount;
+uniform uint  uCapacity;        // length of visible[]
+uniform float uWallHeight;      // unit cubes scaled by this reach y = +-uWallHeight
+uniform vec4  uPlanes[6];       // frustum planes, normals inward
+
+uniform bool      uOcclusion;
+uniform mat4      uPrevViewProj;
+uniform sampler2D uHiZ;         // max depth per texel, one mip per halving
+uniform int       uHiZLevels;
+
+// The box's nearest depth lies behind everything drawn last frame over
+// the screen rect it covers then
+bool occluded(vec3 lo, vec3 hi) {
+    vec2  ndcMin = vec2(1.0), ndcMax = vec2(-1.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 p = vec3((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y, (i & 4) != 0 ? hi.z : lo.z);
+        vec4 clip = uPrevViewProj * vec4(p, 1.0);
+        if (clip.w <= 0.0) return false;   // crosses the eye plane
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin  = min(ndcMin, ndc.xy);
+        ndcMax  = max(ndcMax, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+    // Last frame's depth says nothing about what lay off its screen
+    if (any(lessThan(ndcMin, vec2(-1.0))) || any(greaterThan(ndcMax, vec2(1.0)))) return false;
+    nearest = nearest * 0.5 + 0.5;
+
+    // Pick the level where the rect spans at most 2x2 texels
+    vec2  size   = vec2(textureSize(uHiZ, 0));
+    vec2  pxMin  = (ndcMin * 0.5 + 0.5) * size;
+    vec2  pxMax  = (ndcMax * 0.5 + 0.5) * size;
+    vec2  extent = pxMax - pxMin;
+    int   level  = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, uHiZLevels - 1);
+
+    // Mip sizes as glTexStorage2D makes them; textureSize with a varying
+    // lod is not reliable on every driver
+    ivec2 last = max(ivec2(size) >> level, ivec2(1)) - 1;
+    ivec2 t0   = min(ivec2(pxMin) >> level, last);
+    ivec2 t1   = min(ivec2(pxMax) >> level, last);
+    float farthest = 0.0;
+    for (int y = t0.y; y <= t1.y; ++y)
+        for (int x = t0.x; x <= t1.x; ++x)
+            farthest = max(farthest, texelFetch(uHiZ, ivec2(x, y), level).r);
+    return nearest > farthest;
+}
+
+void main() {
+    if (uFinish) {
+        command.instanceCount = min(command.instanceCount, uCapacity);
+        return;
+    }
+    // Large batches spread over a 2D grid of groups (65535 per axis at most)
+    uint i = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * gl_WorkGroupSize.x +
+             gl_LocalInvocationID.x;
+    if (i >= uInstanceCount) return;
+
+    vec4 b  = bounds[i];
+    vec3 lo = vec3(b.x, -uWallHeight, b.y);
+    vec3 hi = vec3(b.z,  uWallHeight, b.w);
+
+    for (int k = 0; k < 6; ++k) {
+        vec4 p = uPlanes[k];
+        vec3 corner = vec3(p.x > 0.0 ? hi.x : lo.x, p.y > 0.0 ? hi.y : lo.y, p.z > 0.0 ? hi.z : lo.z);
+        if (dot(p.xyz, corner) + p.w < 0.0) return;
+    }
+    if (uOcclusion && occluded(lo, hi)) return;
+
+    uint slot = atomicAdd(command.instanceCount, 1u);
+    if (slot >= uCapacity) return;   // the finish pass clamps the count
+    vec3 center = (lo + hi) * 0.5;
+    visible[slot] = mat4(vec4((hi.x - lo.x) * 0.5, 0.0, 0.0, 0.0),
+                         vec4(0.0, uWallHeight, 0.0, 0.0),
+                         vec4(0.0, 0.0, (hi.z - lo.z) * 0.5, 0.0),
+                         vec4(center.x, 0.0, center.z, 1.0));
+}
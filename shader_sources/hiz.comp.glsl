@@ -0,0 +1,31 @@
+#version 430 core
+
+// One level of the Hi-Z pyramid: each texel keeps the farthest depth of
+// the texels it covers one level down. Mip sizes halve rounding down, so
+// the last row and column also take in the odd one left over: texel t of
+// level n covers pixels [t << n, (t + 1) << n) of the depth buffer, and
+// the last texel runs on to the edge.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform bool      uFromDepth;   // level 0: copy the depth texture as is
+uniform sampler2D uDepth;
+layout(r32f, binding = 0) uniform readonly  image2D uSrc;
+layout(r32f, binding = 1) uniform writeonly image2D uDst;
+
+void main() {
+    ivec2 d = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(d, imageSize(uDst)))) return;
+
+    if (uFromDepth) {
+        imageStore(uDst, d, vec4(texelFetch(uDepth, d, 0).r));
+        return;
+    }
+    ivec2 srcSize = imageSize(uSrc);
+    ivec2 s0 = 2 * d;
+    ivec2 s1 = min(s0 + 1 + ivec2(equal(d, imageSize(uDst) - 1)) * (srcSize & 1), srcSize - 1);
+    float z = 0.0;
+    for (int y = s0.y; y <= s1.y; ++y)
+        for (int x = s0.x; x <= s1.x; ++x)
+            z = max(z, imageLoad(uSrc, ivec2(x, y)).r);
+    imageStore(uDst, d, vec4(z));
+}
@@ -4,6 +4,8 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;        // planar UVs
 layout(location = 3) in mat4 instanceModel;    // start at location 3
+layout(location = 7) in vec3 aPosScale;        // per mesh: packed positions are
+layout(location = 8) in vec3 aPosOffset;       // offset + scale * aPos
 
 uniform mat4 uModel;
 uniform mat4 uView;
@@ -16,7 +18,7 @@ out vec2 TexCoord;
 
 void main() {
     mat4 model = uUseInstancing ? instanceModel : uModel;
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec4 worldPos = model * vec4(aPosOffset + aPosScale * aPos, 1.0);
     FragPos = worldPos.xyz;
     Normal  = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = worldPos.xz * 0.25;
@@ -0,0 +1,55 @@
+// src/AgentResolver.cpp
+#include "AgentResolver.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Spread the low 16 bits of v over the even bits of the result
+std::uint32_t spreadBits(std::uint32_t v) {
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+} // namespace
+
+void AgentResolver::resolve(const CollisionWorld& world,
+                            std::span<const glm::vec3> positions,
+                            std::span<const glm::vec3> deltas,
+                            std::span<const float> radii,
+                            std::span<glm::vec3> out) {
+    const std::size_t n = positions.size();
+    if (deltas.size() != n || out.size() < n)
+        throw std::invalid_argument("AgentResolver: deltas/out must match positions");
+    if (radii.size() != 1 && radii.size() != n)
+        throw std::invalid_argument("AgentResolver: radii must hold 1 or positions.size() values");
+
+    // Order agents along a Z-curve of coarse cells. Ties break on the index,
+    // so the order is fully determined by the input.
+    const float inv = 1.0f / cellSize;
+    order.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint32_t cx = std::uint32_t((std::int32_t)std::floor(positions[i].x * inv) + 0x8000);
+        std::uint32_t cz = std::uint32_t((std::int32_t)std::floor(positions[i].z * inv) + 0x8000);
+        std::uint64_t cell = spreadBits(cx) | (spreadBits(cz) << 1);
+        order[i] = (cell << 32) | std::uint32_t(i);
+    }
+    std::sort(order.begin(), order.end());
+
+    const bool shared = radii.size() == 1;
+    auto body = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+            std::uint32_t i = std::uint32_t(order[k]);
+            out[i] = world.slide(positions[i], deltas[i], shared ? radii[0] : radii[i]);
+        }
+    };
+    if (pool) pool->parallelFor(n, 512, body);
+    else      body(0, n);
+}
@@ -0,0 +1,231 @@
+// src/ChunkStreamer.cpp
+#include "ChunkStreamer.h"
+#include "Frustum.h"
+#include "Map.h"
+#include "OccupancyGrid.h"
+#include "ThreadPool.h"
+#include "WallRects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// One scaled unit cube per merged rect of the chunk's wall cells
+std::vector<glm::mat4> meshRects(const Map& map, const std::vector<WallRect>& rects, float wallHeight) {
+    std::vector<glm::mat4> inst;
+    inst.reserve(rects.size());
+    for (const WallRect& r : rects) {
+        glm::vec3 lo = wallRectMin(map, r);
+        glm::vec3 hi = wallRectMax(map, r, 0.0f);
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), (lo + hi) * 0.5f);
+        m = glm::scale(m, glm::vec3(r.w * 0.5f, wallHeight, r.h * 0.5f));
+        inst.push_back(m);
+    }
+    return inst;
+}
+
+int floorDiv(int a, int b) { return a / b - ((a % b != 0) & ((a < 0) != (b < 0))); }
+
+} // namespace
+
+ChunkStreamer::ChunkStreamer(const Map& map, ThreadPool& pool, const Settings& s)
+    : map(map), pool(pool), settings(s), results(std::make_shared<Results>()) {
+    settings.chunkSize  = std::max(settings.chunkSize, 1);
+    settings.loadRadius = std::max(settings.loadRadius, 0);
+    const std::size_t side = std::size_t(2 * settings.loadRadius + 1);
+    slots   = std::max(settings.maxResidentBytes / slotBytes(), side * side);
+    chunksX = (map.width()  + settings.chunkSize - 1) / settings.chunkSize;
+    chunksY = (map.height() + settings.chunkSize - 1) / settings.chunkSize;
+
+    freeSlots.reserve(slots);
+    for (std::size_t i = slots; i-- > 0; ) freeSlots.push_back(i);
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    std::unique_lock<std::mutex> lock(results->mutex);
+    results->idle.wait(lock, [this] { return results->inFlight == 0; });
+}
+
+void ChunkStreamer::update(const glm::vec3& cameraPos) {
+    ++frame;
+    const glm::ivec2 cell = map.worldToCell(cameraPos);
+    const int ccx = floorDiv(cell.x, settings.chunkSize);
+    const int ccy = floorDiv(cell.y, settings.chunkSize);
+    const int r   = settings.loadRadius;
+
+    std::vector<std::pair<int, glm::ivec2>> missing;
+    for (int cy = std::max(ccy - r, 0); cy <= std::min(ccy + r, chunksY - 1); ++cy) {
+        for (int cx = std::max(ccx - r, 0); cx <= std::min(ccx + r, chunksX - 1); ++cx) {
+            auto it = chunks.find(chunkKey(cx, cy));
+            if (it != chunks.end()) {
+                it->second.lastWanted = frame;
+                continue;
+            }
+            const int dx = cx - ccx, dy = cy - ccy;
+            missing.push_back({ dx * dx + dy * dy, { cx, cy } });
+        }
+    }
+
+    // Wall-less chunks hold no slot; forget them once out of range so the
+    // table stays as small as the resident set
+    for (auto it = chunks.begin(); it != chunks.end(); ) {
+        const Chunk& c = it->second;
+        if (c.resident && c.slot == kNoSlot && c.lastWanted != frame) it = chunks.erase(it);
+        else ++it;
+    }
+
+    // Keep the queue short so a fast-moving camera doesn't leave a backlog
+    // of chunks it has already passed
+    int inFlight;
+    {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        inFlight = results->inFlight;
+    }
+    const int maxInFlight = int(pool.size()) * 2 + 1;
+    std::sort(missing.begin(), missing.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& m : missing) {
+        if (inFlight >= maxInFlight) break;
+        submit(m.second.x, m.second.y);
+        ++inFlight;
+    }
+}
+
+void ChunkStreamer::submit(int cx, int cy) {
+    const std::uint64_t key = chunkKey(cx, cy);
+    Chunk& c = chunks[key];
+    c.lastWanted = frame;
+
+    {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        ++results->inFlight;
+    }
+    pool.submit([res = results, &map = map, key,
+                 x0 = cx * settings.chunkSize, y0 = cy * settings.chunkSize,
+                 size = settings.chunkSize, height = settings.wallHeight] {
+        Built built{ key, mergeWallRects(map, x0, y0, x0 + size, y0 + size), {} };
+        built.instances = meshRects(map, built.rects, height);
+        std::lock_guard<std::mutex> lock(res->mutex);
+        res->ready.push_back(std::move(built));
+        if (--res->inFlight == 0) res->idle.notify_all();
+    });
+}
+
+std::size_t ChunkStreamer::acquireSlot() {
+    if (!freeSlots.empty()) {
+        std::size_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    // Evict the resident chunk that has been out of range the longest
+    auto victim = chunks.end();
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        const Chunk& c = it->second;
+        if (!c.resident || c.slot == kNoSlot || c.lastWanted == frame) continue;
+        if (victim == chunks.end() || c.lastWanted < victim->second.lastWanted) victim = it;
+    }
+    if (victim == chunks.end()) return kNoSlot;
+    std::size_t slot = victim->second.slot;
+    chunks.erase(victim);
+    return slot;
+}
+
+void ChunkStreamer::setVisibleCells(const OccupancyGrid* cells) {
+    visibleCells = cells;
+    ++visibility;
+}
+
+std::size_t ChunkStreamer::fillSlot(Chunk& c,
+                                    const std::function<void(std::size_t, const std::vector<glm::mat4>&)>& upload) {
+    c.shown = visibility;
+    const std::vector<glm::mat4>* inst = &c.instances;
+    if (visibleCells) filtered.clear();
+
+    // Instances are unit cubes scaled by wallHeight, so they reach as far
+    // below y = 0 as above it
+    c.lo = glm::vec3(1e30f);
+    c.hi = glm::vec3(-1e30f);
+    for (std::size_t i = 0; i < c.rects.size(); ++i) {
+        const WallRect& r = c.rects[i];
+        if (visibleCells) {
+            if (!visibleCells->anyInRect(r.x, r.y, r.x + r.w, r.y + r.h)) continue;
+            filtered.push_back(c.instances[i]);
+        }
+        c.lo = glm::min(c.lo, wallRectMin(map, r) - glm::vec3(0.0f, settings.wallHeight, 0.0f));
+        c.hi = glm::max(c.hi, wallRectMax(map, r, settings.wallHeight));
+    }
+    if (visibleCells) inst = &filtered;
+    c.count = inst->size();
+    if (inst->empty()) return 0;
+    upload(c.slot, *inst);
+    return inst->size() * sizeof(glm::mat4);
+}
+
+void ChunkStreamer::upload(const std::function<void(std::size_t, const std::vector<glm::mat4>&)>& upload) {
+    // Slots filled for an older visible set go first: they are the chunks
+    // around the camera, and until refilled they draw what was visible
+    // from the cell it left
+    std::size_t spent = 0;
+    for (auto& [key, c] : chunks) {
+        if (spent >= settings.uploadBytesPerFrame) break;
+        if (c.resident && c.slot != kNoSlot && c.shown != visibility) spent += fillSlot(c, upload);
+    }
+
+    while (spent < settings.uploadBytesPerFrame) {
+        Built built;
+        {
+            std::lock_guard<std::mutex> lock(results->mutex);
+            if (results->ready.empty()) break;
+            built = std::move(results->ready.front());
+            results->ready.pop_front();
+        }
+
+        auto it = chunks.find(built.key);
+        if (it == chunks.end() || it->second.resident) continue;
+        Chunk& c = it->second;
+        if (built.instances.empty()) {
+            c.resident = true;
+            continue;
+        }
+
+        // Every slot holds a chunk wanted this frame; drop the result and
+        // let update() ask again
+        c.slot = acquireSlot();
+        if (c.slot == kNoSlot) {
+            chunks.erase(it);
+            continue;
+        }
+        c.resident  = true;
+        c.rects     = std::move(built.rects);
+        c.instances = std::move(built.instances);
+        spent += fillSlot(c, upload);
+    }
+}
+
+std::size_t ChunkStreamer::forEachResident(const Frustum& frustum,
+                                           const std::function<void(std::size_t, std::size_t)>& draw) const {
+    std::size_t drawn = 0;
+    for (const auto& [key, c] : chunks) {
+        if (!c.resident || c.slot == kNoSlot || c.count == 0 || !frustum.intersectsBox(c.lo, c.hi)) continue;
+        draw(c.slot, c.count);
+        drawn += c.count;
+    }
+    return drawn;
+}
+
+std::size_t ChunkStreamer::residentCount() const {
+    return std::size_t(std::count_if(chunks.begin(), chunks.end(),
+        [](const auto& kv) { return kv.second.resident && kv.second.slot != kNoSlot; }));
+}
+
+std::size_t ChunkStreamer::drawnInstanceCount() const {
+    std::size_t n = 0;
+    for (const auto& [key, c] : chunks)
+        if (c.resident && c.slot != kNoSlot) n += c.count;
+    return n;
+}
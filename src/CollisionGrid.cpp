@@ -1,2 +1,549 @@
 // src/CollisionGrid.cpp
-#include "CollisionGrid.h"
\ No newline at end of file
+#include "CollisionGrid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define T3V_COLLISION_SSE2 1
+#endif
+
+namespace {
+
+#if defined(__AVX2__)
+constexpr std::uint32_t kLanes = 8;
+#elif defined(T3V_COLLISION_SSE2)
+constexpr std::uint32_t kLanes = 4;
+#else
+constexpr std::uint32_t kLanes = 1;
+#endif
+
+// A batch lane group whose spheres spread over more tiles than this is
+// tested one sphere at a time
+constexpr std::int64_t kMaxLaneTiles = 16;
+
+// Per-axis sphere vs box overlap (same rule as AABB::intersectsSphere) over
+// count boxes starting at begin. count is a multiple of kLanes.
+struct BoxPtrs {
+    const float *cx, *cy, *cz;
+    const float *hx, *hy, *hz;
+};
+
+bool anyBoxHit(const BoxPtrs& b, std::uint32_t begin, std::uint32_t count,
+               const glm::vec3& pos, float radius) {
+#if defined(__AVX2__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 px = _mm256_set1_ps(pos.x);
+    const __m256 py = _mm256_set1_ps(pos.y);
+    const __m256 pz = _mm256_set1_ps(pos.z);
+    const __m256 r  = _mm256_set1_ps(radius);
+    for (std::uint32_t i = begin; i < begin + count; i += kLanes) {
+        __m256 dx  = _mm256_and_ps(_mm256_sub_ps(px, _mm256_loadu_ps(b.cx + i)), absMask);
+        __m256 dy  = _mm256_and_ps(_mm256_sub_ps(py, _mm256_loadu_ps(b.cy + i)), absMask);
+        __m256 dz  = _mm256_and_ps(_mm256_sub_ps(pz, _mm256_loadu_ps(b.cz + i)), absMask);
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(b.hx + i), r), _CMP_LE_OQ),
+                     _mm256_and_ps(_mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(b.hy + i), r), _CMP_LE_OQ),
+                                   _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(b.hz + i), r), _CMP_LE_OQ)));
+        if (_mm256_movemask_ps(hit)) return true;
+    }
+    return false;
+#elif defined(T3V_COLLISION_SSE2)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 px = _mm_set1_ps(pos.x);
+    const __m128 py = _mm_set1_ps(pos.y);
+    const __m128 pz = _mm_set1_ps(pos.z);
+    const __m128 r  = _mm_set1_ps(radius);
+    for (std::uint32_t i = begin; i < begin + count; i += kLanes) {
+        __m128 dx  = _mm_and_ps(_mm_sub_ps(px, _mm_loadu_ps(b.cx + i)), absMask);
+        __m128 dy  = _mm_and_ps(_mm_sub_ps(py, _mm_loadu_ps(b.cy + i)), absMask);
+        __m128 dz  = _mm_and_ps(_mm_sub_ps(pz, _mm_loadu_ps(b.cz + i)), absMask);
+        __m128 hit = _mm_and_ps(_mm_cmple_ps(dx, _mm_add_ps(_mm_loadu_ps(b.hx + i), r)),
+                     _mm_and_ps(_mm_cmple_ps(dy, _mm_add_ps(_mm_loadu_ps(b.hy + i), r)),
+                                _mm_cmple_ps(dz, _mm_add_ps(_mm_loadu_ps(b.hz + i), r))));
+        if (_mm_movemask_ps(hit)) return true;
+    }
+    return false;
+#else
+    for (std::uint32_t i = begin; i < begin + count; ++i) {
+        if (std::abs(pos.x - b.cx[i]) <= b.hx[i] + radius &&
+            std::abs(pos.y - b.cy[i]) <= b.hy[i] + radius &&
+            std::abs(pos.z - b.cz[i]) <= b.hz[i] + radius) return true;
+    }
+    return false;
+#endif
+}
+
+// The other way round for batches: box i against kLanes spheres at once
+// (same overlap rule). Returns a bit per sphere that touches the box.
+std::uint32_t boxHitLanes(const BoxPtrs& b, std::uint32_t i, const float* px, const float* py,
+                          const float* pz, const float* r) {
+#if defined(__AVX2__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 rad = _mm256_loadu_ps(r);
+    __m256 dx  = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(px), _mm256_set1_ps(b.cx[i])), absMask);
+    __m256 dy  = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(py), _mm256_set1_ps(b.cy[i])), absMask);
+    __m256 dz  = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pz), _mm256_set1_ps(b.cz[i])), absMask);
+    __m256 hit = _mm256_and_ps(_mm256_cmp_ps(dx, _mm256_add_ps(_mm256_set1_ps(b.hx[i]), rad), _CMP_LE_OQ),
+                 _mm256_and_ps(_mm256_cmp_ps(dy, _mm256_add_ps(_mm256_set1_ps(b.hy[i]), rad), _CMP_LE_OQ),
+                               _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_set1_ps(b.hz[i]), rad), _CMP_LE_OQ)));
+    return std::uint32_t(_mm256_movemask_ps(hit));
+#elif defined(T3V_COLLISION_SSE2)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 rad = _mm_loadu_ps(r);
+    __m128 dx  = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(px), _mm_set1_ps(b.cx[i])), absMask);
+    __m128 dy  = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(py), _mm_set1_ps(b.cy[i])), absMask);
+    __m128 dz  = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(pz), _mm_set1_ps(b.cz[i])), absMask);
+    __m128 hit = _mm_and_ps(_mm_cmple_ps(dx, _mm_add_ps(_mm_set1_ps(b.hx[i]), rad)),
+                 _mm_and_ps(_mm_cmple_ps(dy, _mm_add_ps(_mm_set1_ps(b.hy[i]), rad)),
+                            _mm_cmple_ps(dz, _mm_add_ps(_mm_set1_ps(b.hz[i]), rad))));
+    return std::uint32_t(_mm_movemask_ps(hit));
+#else
+    return std::abs(px[0] - b.cx[i]) <= b.hx[i] + r[0] &&
+           std::abs(py[0] - b.cy[i]) <= b.hy[i] + r[0] &&
+           std::abs(pz[0] - b.cz[i]) <= b.hz[i] + r[0];
+#endif
+}
+
+#if defined(__AVX2__)
+// Tile-mode test of 8 spheres, each with radius < 1 so it touches at most
+// 3x3 cells: the wall bits of all 8 are gathered one neighbour offset at a
+// time. words is the map's occupancy grid read as 32-bit halves (x86 is
+// little-endian, so cell x of a row is bit x & 31 of half x >> 5).
+std::uint32_t tileHitLanes(const std::uint32_t* words, int halvesPerRow, int w, int h,
+                           float wallHeight, const float* px, const float* py,
+                           const float* pz, const float* r) {
+    const __m256 rad  = _mm256_loadu_ps(r);
+    const __m256 half = _mm256_set1_ps(wallHeight * 0.5f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 x = _mm256_loadu_ps(px), z = _mm256_loadu_ps(pz);
+    const __m256 dy = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(py), half), absMask);
+    const __m256i inY = _mm256_castps_si256(_mm256_cmp_ps(dy, _mm256_add_ps(half, rad), _CMP_LE_OQ));
+
+    const __m256i x0 = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_sub_ps(x, rad)));
+    const __m256i x1 = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_add_ps(x, rad)));
+    const __m256i z0 = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_sub_ps(z, rad)));
+    const __m256i z1 = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_add_ps(z, rad)));
+    const __m256i one = _mm256_set1_epi32(1), zero = _mm256_setzero_si256();
+    const __m256i width = _mm256_set1_epi32(w), height = _mm256_set1_epi32(h);
+    const __m256i lastRow = _mm256_set1_epi32(h - 1), stride = _mm256_set1_epi32(halvesPerRow);
+
+    __m256i hit = zero;
+    for (int oz = 0; oz < 3; ++oz) {
+        const __m256i cz = _mm256_add_epi32(z0, _mm256_set1_epi32(oz));
+        const __m256i my = _mm256_sub_epi32(lastRow, cz);   // map rows run against world z
+        const __m256i rowOk = _mm256_andnot_si256(_mm256_cmpgt_epi32(cz, z1),
+            _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, my), _mm256_cmpgt_epi32(height, my)));
+        for (int ox = 0; ox < 3; ++ox) {
+            const __m256i cx = _mm256_add_epi32(x0, _mm256_set1_epi32(ox));
+            const __m256i ok = _mm256_and_si256(_mm256_and_si256(rowOk, inY),
+                _mm256_andnot_si256(_mm256_cmpgt_epi32(cx, x1),
+                    _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, cx), _mm256_cmpgt_epi32(width, cx))));
+            if (_mm256_testz_si256(ok, ok)) continue;
+            const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(my, stride), _mm256_srli_epi32(cx, 5));
+            const __m256i word = _mm256_mask_i32gather_epi32(zero, reinterpret_cast<const int*>(words),
+                                                             _mm256_and_si256(index, ok), ok, 4);
+            const __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(cx, _mm256_set1_epi32(31))), one);
+            hit = _mm256_or_si256(hit, _mm256_and_si256(bit, ok));
+        }
+    }
+    return std::uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hit, one))));
+}
+#endif
+
+// Ray start + t * delta against the box [bmin, bmax]. On entry at t in
+// [0, hit.toi) updates hit. Starting inside the box is not a hit.
+void sweepBox(const glm::vec3& start, const glm::vec3& delta,
+              const glm::vec3& bmin, const glm::vec3& bmax, SweepHit& hit) {
+    float tNear = -std::numeric_limits<float>::infinity();
+    float tFar  =  std::numeric_limits<float>::infinity();
+    int   axis  = -1;
+    for (int a = 0; a < 3; ++a) {
+        if (std::abs(delta[a]) < 1e-8f) {
+            if (start[a] < bmin[a] || start[a] > bmax[a]) return;
+            continue;
+        }
+        float inv = 1.0f / delta[a];
+        float t0 = (bmin[a] - start[a]) * inv;
+        float t1 = (bmax[a] - start[a]) * inv;
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > tNear) { tNear = t0; axis = a; }
+        tFar = std::min(tFar, t1);
+    }
+    if (axis < 0 || tNear > tFar || tNear < 0.0f || tNear >= hit.toi) return;
+
+    hit.hit = true;
+    hit.toi = tNear;
+    hit.normal = glm::vec3(0);
+    hit.normal[axis] = delta[axis] > 0.0f ? -1.0f : 1.0f;
+}
+
+// Ray origin + t * dir against the box [bmin, bmax]. Returns the entry t
+// (0 when starting inside, with axis = -1) or a negative value on a miss.
+float rayBox(const glm::vec3& origin, const glm::vec3& dir,
+             const glm::vec3& bmin, const glm::vec3& bmax, int& axis) {
+    float tNear = 0.0f;
+    float tFar  = std::numeric_limits<float>::infinity();
+    axis = -1;
+    for (int a = 0; a < 3; ++a) {
+        if (std::abs(dir[a]) < 1e-8f) {
+            if (origin[a] < bmin[a] || origin[a] > bmax[a]) return -1.0f;
+            continue;
+        }
+        float inv = 1.0f / dir[a];
+        float t0 = (bmin[a] - origin[a]) * inv;
+        float t1 = (bmax[a] - origin[a]) * inv;
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > tNear) { tNear = t0; axis = a; }
+        tFar = std::min(tFar, t1);
+        if (tNear > tFar) return -1.0f;
+    }
+    return tNear;
+}
+
+} // namespace
+
+void CollisionGrid::build(const std::vector<glm::vec3>& wallPositions, float wallHeight) {
+    mode = Mode::Boxes;
+    map = nullptr;
+    this->wallHeight = wallHeight;
+
+    std::vector<AABB> aabbs;
+    aabbs.reserve(wallPositions.size());
+    for (auto& wp : wallPositions) {
+        AABB box;
+        box.center = glm::vec3(wp.x, wallHeight * 0.5f, wp.z);
+        box.halfExtents = glm::vec3(std::max(0.5f, wallHeight * 0.5f));
+        aabbs.push_back(box);
+    }
+    buildBoxes(aabbs);
+}
+
+void CollisionGrid::build(const Map& map, const std::vector<WallRect>& rects, float wallHeight) {
+    mode = Mode::Boxes;
+    this->map = nullptr;
+    this->wallHeight = wallHeight;
+
+    std::vector<AABB> aabbs;
+    aabbs.reserve(rects.size());
+    for (auto& r : rects) {
+        glm::vec3 lo = wallRectMin(map, r);
+        glm::vec3 hi = wallRectMax(map, r, wallHeight);
+        aabbs.push_back({ (lo + hi) * 0.5f, (hi - lo) * 0.5f });
+    }
+    buildBoxes(aabbs);
+}
+
+void CollisionGrid::buildBoxes(const std::vector<AABB>& aabbs) {
+    boxes = {};
+    cells.clear();
+    minY = std::numeric_limits<float>::infinity();
+    maxY = -minY;
+
+    // Insert each box into every tile its XZ footprint touches (bounds inclusive,
+    // matching the <= test in AABB::intersectsSphere)
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> buckets;
+    for (std::uint32_t i = 0; i < aabbs.size(); ++i) {
+        const AABB& box = aabbs[i];
+        int x0 = (int)std::floor(box.center.x - box.halfExtents.x);
+        int x1 = (int)std::floor(box.center.x + box.halfExtents.x);
+        int z0 = (int)std::floor(box.center.z - box.halfExtents.z);
+        int z1 = (int)std::floor(box.center.z + box.halfExtents.z);
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                buckets[cellKey(x, z)].push_back(i);
+        minY = std::min(minY, box.center.y - box.halfExtents.y);
+        maxY = std::max(maxY, box.center.y + box.halfExtents.y);
+    }
+
+    // Flatten the buckets into lane-padded SoA runs. Padding boxes sit at
+    // +inf with zero size, so every compare against them fails.
+    const float far = std::numeric_limits<float>::infinity();
+    cells.reserve(buckets.size());
+    for (auto& [key, ids] : buckets) {
+        CellRange range;
+        range.begin = (std::uint32_t)boxes.cx.size();
+        range.count = (std::uint32_t)((ids.size() + kLanes - 1) / kLanes * kLanes);
+        for (std::uint32_t k = 0; k < range.count; ++k) {
+            bool real = k < ids.size();
+            const AABB* box = real ? &aabbs[ids[k]] : nullptr;
+            boxes.cx.push_back(real ? box->center.x : far);
+            boxes.cy.push_back(real ? box->center.y : far);
+            boxes.cz.push_back(real ? box->center.z : far);
+            boxes.hx.push_back(real ? box->halfExtents.x : 0.0f);
+            boxes.hy.push_back(real ? box->halfExtents.y : 0.0f);
+            boxes.hz.push_back(real ? box->halfExtents.z : 0.0f);
+        }
+        cells.emplace(key, range);
+    }
+}
+
+void CollisionGrid::build(const Map& map, float wallHeight) {
+    mode = Mode::Tiles;
+    this->map = &map;
+    this->wallHeight = wallHeight;
+    minY = 0.0f;
+    maxY = wallHeight;
+    boxes = {};
+    cells.clear();
+}
+
+bool CollisionGrid::collides(const glm::vec3& pos, float radius) const {
+    return mode == Mode::Tiles ? collidesTiles(pos, radius)
+                               : collidesBoxes(pos, radius);
+}
+
+void CollisionGrid::collidesBatch(std::span<const glm::vec3> positions,
+                                  std::span<const float> radii,
+                                  std::span<std::uint8_t> out) const {
+    if (out.size() < positions.size())
+        throw std::invalid_argument("collidesBatch: output span too small");
+    if (radii.size() != 1 && radii.size() != positions.size())
+        throw std::invalid_argument("collidesBatch: radii must hold 1 or positions.size() values");
+
+    const bool shared = radii.size() == 1;
+    auto radius = [&](std::size_t i) { return shared ? radii[0] : radii[i]; };
+#if !defined(__AVX2__)
+    // Without gathers tile mode has nothing to do in lanes
+    if (mode == Mode::Tiles) {
+        for (std::size_t i = 0; i < positions.size(); ++i) out[i] = collidesTiles(positions[i], radius(i));
+        return;
+    }
+#endif
+
+    // kLanes spheres at a time, in lanes. Unused lanes sit at infinity,
+    // where nothing is hit.
+    const float inf = std::numeric_limits<float>::infinity();
+    for (std::size_t first = 0; first < positions.size(); first += kLanes) {
+        const std::size_t n = std::min<std::size_t>(kLanes, positions.size() - first);
+        float px[kLanes], py[kLanes], pz[kLanes], r[kLanes];
+        float rMax = 0.0f;
+        for (std::size_t k = 0; k < kLanes; ++k) {
+            const bool real = k < n;
+            px[k] = real ? positions[first + k].x : inf;
+            py[k] = real ? positions[first + k].y : inf;
+            pz[k] = real ? positions[first + k].z : inf;
+            r[k]  = real ? radius(first + k) : 0.0f;
+            rMax  = std::max(rMax, r[k]);
+        }
+        if (collidesLanes(px, py, pz, r, rMax, n, out.subspan(first, n))) continue;
+
+        for (std::size_t k = 0; k < n; ++k)
+            out[first + k] = collides(positions[first + k], r[k]);
+    }
+}
+
+// Spheres too spread out for one neighbourhood, or too large for the tile
+// kernel, return false and are tested one at a time
+bool CollisionGrid::collidesLanes(const float* px, const float* py, const float* pz, const float* r,
+                                  float rMax, std::size_t n, std::span<std::uint8_t> out) const {
+    std::uint32_t hits = 0;
+    if (mode == Mode::Tiles) {
+#if defined(__AVX2__)
+        const OccupancyGrid& walls = map->walls;
+        if (rMax >= 1.0f || walls.wordCount() * 2 > std::size_t(0x7fffffff)) return false;
+        hits = tileHitLanes(reinterpret_cast<const std::uint32_t*>(walls.data()), int(walls.wordsPerRow() * 2),
+                            walls.width(), walls.height(), wallHeight, px, py, pz, r);
+#else
+        return false;   // not reached: collidesBatch loops itself
+#endif
+    } else {
+        // Every box that can touch one of the spheres lies in the tiles
+        // covering all of them; one pass over those boxes tests each
+        // against every lane
+        float lx = px[0], hx = px[0], lz = pz[0], hz = pz[0];
+        for (std::size_t k = 1; k < n; ++k) {
+            lx = std::min(lx, px[k]); hx = std::max(hx, px[k]);
+            lz = std::min(lz, pz[k]); hz = std::max(hz, pz[k]);
+        }
+        const int x0 = (int)std::floor(lx - rMax), x1 = (int)std::floor(hx + rMax);
+        const int z0 = (int)std::floor(lz - rMax), z1 = (int)std::floor(hz + rMax);
+        if (std::int64_t(x1 - x0 + 1) * (z1 - z0 + 1) > kMaxLaneTiles) return false;
+
+        const std::uint32_t all = (std::uint32_t(1) << n) - 1;
+        BoxPtrs b{ boxes.cx.data(), boxes.cy.data(), boxes.cz.data(),
+                   boxes.hx.data(), boxes.hy.data(), boxes.hz.data() };
+        for (int z = z0; z <= z1 && hits != all; ++z) {
+            for (int x = x0; x <= x1 && hits != all; ++x) {
+                auto it = cells.find(cellKey(x, z));
+                if (it == cells.end()) continue;
+                const CellRange& range = it->second;
+                for (std::uint32_t i = range.begin; i < range.begin + range.count && hits != all; ++i)
+                    hits |= boxHitLanes(b, i, px, py, pz, r) & all;
+            }
+        }
+    }
+    for (std::size_t k = 0; k < n; ++k) out[k] = (hits >> k) & 1;
+    return true;
+}
+
+bool CollisionGrid::collidesBoxes(const glm::vec3& pos, float radius) const {
+    int x0 = (int)std::floor(pos.x - radius);
+    int x1 = (int)std::floor(pos.x + radius);
+    int z0 = (int)std::floor(pos.z - radius);
+    int z1 = (int)std::floor(pos.z + radius);
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            auto it = cells.find(cellKey(x, z));
+            if (it == cells.end()) continue;
+            BoxPtrs b{ boxes.cx.data(), boxes.cy.data(), boxes.cz.data(),
+                       boxes.hx.data(), boxes.hy.data(), boxes.hz.data() };
+            if (anyBoxHit(b, it->second.begin, it->second.count, pos, radius))
+                return true;
+        }
+    }
+    return false;
+}
+
+// Each wall cell is the box [x, x+1] x [0, wallHeight] x [z, z+1]. The test is
+// the same per-axis overlap as AABB::intersectsSphere, so for radius < 1 it
+// visits at most the 3x3 cells around pos.
+bool CollisionGrid::collidesTiles(const glm::vec3& pos, float radius) const {
+    if (std::abs(pos.y - wallHeight * 0.5f) > wallHeight * 0.5f + radius) return false;
+
+    int x0 = (int)std::floor(pos.x - radius);
+    int x1 = (int)std::floor(pos.x + radius);
+    int z0 = (int)std::floor(pos.z - radius);
+    int z1 = (int)std::floor(pos.z + radius);
+    int rows = map->height();
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            if (map->isWall(x, rows - 1 - z)) return true;
+        }
+    }
+    return false;
+}
+
+SweepHit CollisionGrid::sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const {
+    return mode == Mode::Tiles ? sweepTiles(start, delta, radius)
+                               : sweepBoxes(start, delta, radius);
+}
+
+// The per-axis overlap rule makes each box grown by radius an exact
+// Minkowski sum, so sweeping the sphere is a ray cast against grown boxes.
+SweepHit CollisionGrid::sweepBoxes(const glm::vec3& start, const glm::vec3& delta, float radius) const {
+    SweepHit hit;
+    glm::vec3 end = start + delta;
+    int x0 = (int)std::floor(std::min(start.x, end.x) - radius);
+    int x1 = (int)std::floor(std::max(start.x, end.x) + radius);
+    int z0 = (int)std::floor(std::min(start.z, end.z) - radius);
+    int z1 = (int)std::floor(std::max(start.z, end.z) + radius);
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            auto it = cells.find(cellKey(x, z));
+            if (it == cells.end()) continue;
+            const CellRange& range = it->second;
+            for (std::uint32_t i = range.begin; i < range.begin + range.count; ++i) {
+                if (boxes.hx[i] <= 0.0f) continue;   // lane padding
+                glm::vec3 c(boxes.cx[i], boxes.cy[i], boxes.cz[i]);
+                glm::vec3 e = glm::vec3(boxes.hx[i], boxes.hy[i], boxes.hz[i]) + radius;
+                sweepBox(start, delta, c - e, c + e, hit);
+            }
+        }
+    }
+    return hit;
+}
+
+SweepHit CollisionGrid::sweepTiles(const glm::vec3& start, const glm::vec3& delta, float radius) const {
+    SweepHit hit;
+    glm::vec3 end = start + delta;
+    int x0 = (int)std::floor(std::min(start.x, end.x) - radius);
+    int x1 = (int)std::floor(std::max(start.x, end.x) + radius);
+    int z0 = (int)std::floor(std::min(start.z, end.z) - radius);
+    int z1 = (int)std::floor(std::max(start.z, end.z) + radius);
+    int rows = map->height();
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            if (!map->isWall(x, rows - 1 - z)) continue;
+            glm::vec3 bmin(x - radius, -radius, z - radius);
+            glm::vec3 bmax(x + 1 + radius, wallHeight + radius, z + 1 + radius);
+            sweepBox(start, delta, bmin, bmax, hit);
+        }
+    }
+    return hit;
+}
+
+bool CollisionGrid::raycastTile(int x, int z, const glm::vec3& origin, const glm::vec3& dir,
+                                float tLimit, RayHit& hit) const {
+    bool found = false;
+    auto test = [&](const glm::vec3& bmin, const glm::vec3& bmax) {
+        int axis;
+        float t = rayBox(origin, dir, bmin, bmax, axis);
+        if (t < 0.0f || t > tLimit || (found && t >= hit.distance)) return;
+        found = true;
+        hit.distance = t;
+        hit.normal = glm::vec3(0);
+        if (axis >= 0) hit.normal[axis] = dir[axis] > 0.0f ? -1.0f : 1.0f;
+    };
+
+    if (mode == Mode::Tiles) {
+        if (map->isWall(x, map->height() - 1 - z))
+            test(glm::vec3(x, 0.0f, z), glm::vec3(x + 1, wallHeight, z + 1));
+    } else {
+        auto it = cells.find(cellKey(x, z));
+        if (it == cells.end()) return false;
+        const CellRange& range = it->second;
+        for (std::uint32_t i = range.begin; i < range.begin + range.count; ++i) {
+            if (boxes.hx[i] <= 0.0f) continue;   // lane padding
+            glm::vec3 c(boxes.cx[i], boxes.cy[i], boxes.cz[i]);
+            glm::vec3 e(boxes.hx[i], boxes.hy[i], boxes.hz[i]);
+            test(c - e, c + e);
+        }
+    }
+    if (found) {
+        hit.hit = true;
+        hit.point = origin + dir * hit.distance;
+        hit.tile = glm::ivec2(x, z);
+    }
+    return found;
+}
+
+RayHit CollisionGrid::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDist) const {
+    RayHit hit;
+    float len = glm::length(direction);
+    if (len <= 0.0f || maxDist <= 0.0f) return hit;
+    glm::vec3 dir = direction / len;
+
+    // DDA over XZ tiles: tMax* is the distance to the next tile boundary on
+    // each axis, tDelta* the distance between boundaries
+    const float inf = std::numeric_limits<float>::infinity();
+    int x = (int)std::floor(origin.x);
+    int z = (int)std::floor(origin.z);
+    int stepX = dir.x > 0.0f ? 1 : -1;
+    int stepZ = dir.z > 0.0f ? 1 : -1;
+    float tDeltaX = dir.x != 0.0f ? std::abs(1.0f / dir.x) : inf;
+    float tDeltaZ = dir.z != 0.0f ? std::abs(1.0f / dir.z) : inf;
+    float tMaxX = dir.x > 0.0f ? (x + 1 - origin.x) * tDeltaX
+                : dir.x < 0.0f ? (origin.x - x) * tDeltaX : inf;
+    float tMaxZ = dir.z > 0.0f ? (z + 1 - origin.z) * tDeltaZ
+                : dir.z < 0.0f ? (origin.z - z) * tDeltaZ : inf;
+
+    float t = 0.0f;
+    while (t <= maxDist) {
+        float tNext = std::min(tMaxX, tMaxZ);
+        if (raycastTile(x, z, origin, dir, std::min(tNext, maxDist), hit)) return hit;
+
+        float y = origin.y + dir.y * tNext;
+        if ((dir.y > 0.0f && y > maxY) || (dir.y < 0.0f && y < minY)) break;   // left the wall band
+
+        if (tMaxX < tMaxZ) { x += stepX; t = tMaxX; tMaxX += tDeltaX; }
+        else               { z += stepZ; t = tMaxZ; tMaxZ += tDeltaZ; }
+    }
+    return hit;
+}
+
+void CollisionGrid::raycastBatch(std::span<const Ray> rays, std::span<RayHit> out, ThreadPool& pool) const {
+    if (out.size() < rays.size())
+        throw std::invalid_argument("raycastBatch: output span too small");
+
+    // The grid is read-only during queries, so chunks need no locking
+    pool.parallelFor(rays.size(), 256, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = raycast(rays[i].origin, rays[i].dir, rays[i].maxDist);
+    });
+}
@@ -0,0 +1,53 @@
+// src/CollisionWorld.cpp
+#include "CollisionWorld.h"
+
+#include <algorithm>
+
+// Distance a slide step stops short of a surface, so the next step starts clear
+static constexpr float kSkin = 1e-3f;
+
+glm::vec3 CollisionWorld::slide(const glm::vec3& start, const glm::vec3& delta, float radius,
+                                int maxIterations) const {
+    glm::vec3 pos = start;
+    glm::vec3 remaining = delta;
+    for (int i = 0; i < maxIterations; ++i) {
+        if (glm::dot(remaining, remaining) < 1e-12f) break;
+        SweepHit hit = sweep(pos, remaining, radius);
+        if (!hit.hit) {
+            pos += remaining;
+            break;
+        }
+        // Stop just short of contact (backing off along both the motion and
+        // the normal keeps concave corners clear), then keep only the part of
+        // the leftover motion that runs along the surface
+        float back = kSkin / glm::length(remaining);
+        pos += remaining * std::max(0.0f, hit.toi - back) + hit.normal * kSkin;
+        remaining *= (1.0f - hit.toi);
+        remaining -= hit.normal * glm::dot(remaining, hit.normal);
+    }
+    return pos;
+}
+
+bool CollisionSet::collides(const glm::vec3& pos, float radius) const {
+    for (auto* m : members)
+        if (m->collides(pos, radius)) return true;
+    return false;
+}
+
+SweepHit CollisionSet::sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const {
+    SweepHit best;
+    for (auto* m : members) {
+        SweepHit h = m->sweep(start, delta, radius);
+        if (h.hit && h.toi < best.toi) best = h;
+    }
+    return best;
+}
+
+RayHit CollisionSet::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const {
+    RayHit best;
+    for (auto* m : members) {
+        RayHit h = m->raycast(origin, dir, maxDist);
+        if (h.hit && (!best.hit || h.distance < best.distance)) best = h;
+    }
+    return best;
+}
@@ -0,0 +1,192 @@
+// src/GpuCuller.cpp
+#include "GpuCuller.h"
+#include "Frustum.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr GLuint kCullGroupSize    = 64;   // local_size_x in cull.comp.glsl
+constexpr GLuint kPyramidGroupSize = 8;    // local_size_x/y in hiz.comp.glsl
+constexpr GLuint kMaxGroupsPerAxis = 65535;
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+GLuint buildComputeProgram(const std::string& source) {
+    const char* src = source.c_str();
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+    GLint ok;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, 512, nullptr, log);
+        glDeleteShader(shader);
+        throw std::runtime_error(log);
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        glDeleteProgram(program);
+        throw std::runtime_error(log);
+    }
+    return program;
+}
+
+GLuint groupsFor(int n, GLuint groupSize) { return (GLuint(n) + groupSize - 1) / groupSize; }
+
+} // namespace
+
+bool GpuCuller::supported() {
+    return GLEW_VERSION_4_3;
+}
+
+GpuCuller::GpuCuller(const std::string& cullSource, const std::string& pyramidSource, const Settings& s)
+    : settings(s) {
+    settings.capacity = std::max<std::size_t>(settings.capacity, 1);
+    cullProgram    = buildComputeProgram(cullSource);
+    pyramidProgram = buildComputeProgram(pyramidSource);
+
+    glGenBuffers(1, &bounds);
+    glGenBuffers(1, &visible);
+    glGenBuffers(1, &command);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, settings.capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, command);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GpuCuller::~GpuCuller() {
+    if (pyramid)        glDeleteTextures(1, &pyramid);
+    if (depth)          glDeleteTextures(1, &depth);
+    if (command)        glDeleteBuffers(1, &command);
+    if (visible)        glDeleteBuffers(1, &visible);
+    if (bounds)         glDeleteBuffers(1, &bounds);
+    if (pyramidProgram) glDeleteProgram(pyramidProgram);
+    if (cullProgram)    glDeleteProgram(cullProgram);
+}
+
+void GpuCuller::upload(const Map& map, const std::vector<WallRect>& rects, GLsizei indexCount) {
+    // World XZ bounds; the heights are the same for every wall
+    std::vector<glm::vec4> data;
+    data.reserve(rects.size());
+    for (const WallRect& r : rects) {
+        const glm::vec3 lo = wallRectMin(map, r), hi = wallRectMax(map, r, 0.0f);
+        data.push_back({ lo.x, lo.z, hi.x, hi.z });
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(glm::vec4), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    instances = rects.size();
+    indices   = indexCount;
+}
+
+void GpuCuller::cull(const glm::mat4& viewProj) {
+    const DrawElementsIndirectCommand reset{ GLuint(indices), 0, 0, 0, 0 };
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, command);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(reset), &reset);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (instances == 0) return;
+
+    const Frustum frustum(viewProj);
+    const bool occlusion = settings.occlusion && haveDepth;
+    glUseProgram(cullProgram);
+    glUniform1i(glGetUniformLocation(cullProgram, "uFinish"), 0);
+    glUniform1ui(glGetUniformLocation(cullProgram, "uInstanceCount"), GLuint(instances));
+    glUniform1ui(glGetUniformLocation(cullProgram, "uCapacity"), GLuint(settings.capacity));
+    glUniform1f(glGetUniformLocation(cullProgram, "uWallHeight"), settings.wallHeight);
+    glUniform4fv(glGetUniformLocation(cullProgram, "uPlanes"), 6, &frustum.planes[0].x);
+    glUniform1i(glGetUniformLocation(cullProgram, "uOcclusion"), occlusion);
+    if (occlusion) {
+        glUniformMatrix4fv(glGetUniformLocation(cullProgram, "uPrevViewProj"), 1, GL_FALSE, &prevViewProj[0][0]);
+        glUniform1i(glGetUniformLocation(cullProgram, "uHiZLevels"), levels);
+        glUniform1i(glGetUniformLocation(cullProgram, "uHiZ"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, pyramid);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, command);
+
+    const GLuint groups = groupsFor(int(instances), kCullGroupSize);
+    const GLuint gx = std::min(groups, kMaxGroupsPerAxis);
+    glDispatchCompute(gx, (groups + gx - 1) / gx, 1);
+
+    // Instances past the capacity were counted but not stored
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(glGetUniformLocation(cullProgram, "uFinish"), 1);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuCuller::allocatePyramid(int width, int height) {
+    if (pyramid) glDeleteTextures(1, &pyramid);
+    if (depth)   glDeleteTextures(1, &depth);
+    depthW = width;
+    depthH = height;
+    levels = 1;
+    while ((std::max(width, height) >> levels) > 0) ++levels;
+
+    glGenTextures(1, &depth);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &pyramid);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GpuCuller::captureDepth(int width, int height, const glm::mat4& viewProj) {
+    if (width <= 0 || height <= 0) return;
+    if (width != depthW || height != depthH) allocatePyramid(width, height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    glUseProgram(pyramidProgram);
+    glUniform1i(glGetUniformLocation(pyramidProgram, "uDepth"), 0);
+    for (int level = 0; level < levels; ++level) {
+        const int w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+        glUniform1i(glGetUniformLocation(pyramidProgram, "uFromDepth"), level == 0);
+        glBindImageTexture(0, pyramid, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(groupsFor(w, kPyramidGroupSize), groupsFor(h, kPyramidGroupSize), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    prevViewProj = viewProj;
+    haveDepth    = true;
+}
+
+std::size_t GpuCuller::drawnCount() const {
+    DrawElementsIndirectCommand cmd{};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, command);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(cmd), &cmd);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return cmd.instanceCount;
+}
@@ -0,0 +1,75 @@
+// src/GpuCuller.h
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "WallRects.h"
+
+struct Map;
+
+// GPU-driven wall culling for GL 4.3+. Every wall instance is uploaded
+// once to a storage buffer as its world XZ bounds. Each frame, a compute
+// pass tests them all against the view frustum and against a Hi-Z pyramid
+// (farthest depth per mip texel) built from the previous frame's depth.
+// Survivors append their model matrix to an instance buffer and bump the
+// instance count of a DrawElementsIndirectCommand, so the walls draw with
+// one glDrawElementsIndirect. The CPU never reads or writes per-instance data
+// after upload().
+//
+// Occlusion uses last frame's depth and view-projection, so a wall that
+// comes out from behind another appears one frame late.
+class GpuCuller {
+public:
+    struct Settings {
+        std::size_t capacity   = std::size_t(1) << 18;   // instances drawn per frame, at most
+        float       wallHeight = 3.0f;
+        bool        occlusion  = true;                   // false: frustum only
+    };
+
+    // Compute shaders, storage buffers and indirect draws (GL 4.3)?
+    static bool supported();
+
+    // cullSource and pyramidSource are cull.comp.glsl and hiz.comp.glsl;
+    // throws std::runtime_error if either fails to build
+    GpuCuller(const std::string& cullSource, const std::string& pyramidSource, const Settings& settings);
+    ~GpuCuller();
+
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+
+    // Replace the instances with one per rect, each drawn with
+    // indexCount indices (the wall mesh's)
+    void upload(const Map& map, const std::vector<WallRect>& rects, GLsizei indexCount);
+
+    // Fill instanceBuffer() and commandBuffer() for this view. Changes the
+    // bound program and texture unit 0.
+    void cull(const glm::mat4& viewProj);
+
+    // Call once the frame's occluders are drawn: keep the depth of the read
+    // framebuffer (width x height) and viewProj for the next cull()
+    void captureDepth(int width, int height, const glm::mat4& viewProj);
+
+    // Model matrices (mat4 per instance) and the indirect command for them
+    GLuint instanceBuffer() const { return visible; }
+    GLuint commandBuffer() const  { return command; }
+    std::size_t instanceCount() const { return instances; }
+
+    // Instances the last cull() kept; waits for the GPU, so for stats only
+    std::size_t drawnCount() const;
+
+private:
+    void allocatePyramid(int width, int height);
+
+    Settings    settings;
+    GLuint      cullProgram = 0, pyramidProgram = 0;
+    GLuint      bounds = 0, visible = 0, command = 0;
+    GLuint      depth = 0, pyramid = 0;   // depth copy, R32F mip chain
+    int         depthW = 0, depthH = 0, levels = 0;
+    bool        haveDepth = false;
+    glm::mat4   prevViewProj{ 1.0f };
+    std::size_t instances = 0;
+    GLsizei     indices = 0;              // per instance, for the command
+};
@@ -2,15 +2,102 @@
 #include "tiny_obj_loader.h"
 
 #include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <filesystem>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "Mesh.h"
 
-Mesh::Mesh(const std::string& objPath) {
+namespace {
+
+// One interleaved vertex (pos, normal, uv), compared bit for bit
+struct VertexKey {
+    float v[8];
+    bool operator==(const VertexKey& o) const { return std::memcmp(v, o.v, sizeof(v)) == 0; }
+};
+
+struct VertexKeyHash {
+    std::size_t operator()(const VertexKey& k) const {
+        std::uint64_t h = 1469598103934665603ull;
+        for (float f : k.v) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            h = (h ^ bits) * 1099511628211ull;
+        }
+        return std::size_t(h ^ (h >> 32));
+    }
+};
+
+// Collapse repeated vertices of a triangle list; indices[i] is the unique
+// vertex for list vertex i, so ranges of the list are ranges of indices
+void deduplicate(const std::vector<float>& list, std::vector<float>& vertices, std::vector<std::uint32_t>& indices) {
+    const std::size_t n = list.size() / 8;
+    std::unordered_map<VertexKey, std::uint32_t, VertexKeyHash> seen;
+    seen.reserve(n);
+    vertices.clear();
+    indices.clear();
+    indices.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        VertexKey key;
+        std::memcpy(key.v, &list[i * 8], sizeof(key.v));
+        auto [it, added] = seen.try_emplace(key, std::uint32_t(vertices.size() / 8));
+        if (added) vertices.insert(vertices.end(), key.v, key.v + 8);
+        indices.push_back(it->second);
+    }
+}
+
+// VertexFormat::Packed: 16 bytes instead of 32
+struct PackedVertex {
+    std::int16_t  pos[4];   // xyz in steps of the mesh's scale from its offset; w unused
+    std::uint32_t normal;   // snorm 10-10-10-2
+    std::uint32_t uv;       // 2 x half
+};
+static_assert(sizeof(PackedVertex) == 16);
+
+// Positions become int16 counts of a power-of-two step per axis, centred
+// on a multiple of that step, so coordinates on the step grid (integers,
+// halves, ...) survive exactly and shared edges stay closed
+std::vector<PackedVertex> pack(const std::vector<float>& data, glm::vec3& step, glm::vec3& offset) {
+    const std::size_t n = data.size() / 8;
+    glm::vec3 lo(0.0f), hi(0.0f);
+    for (std::size_t i = 0; i < n; ++i) {
+        const glm::vec3 p(data[i * 8], data[i * 8 + 1], data[i * 8 + 2]);
+        lo = i ? glm::min(lo, p) : p;
+        hi = i ? glm::max(hi, p) : p;
+    }
+    for (int a = 0; a < 3; ++a) {
+        const float half = (hi[a] - lo[a]) * 0.5f;
+        step[a]   = half > 0.0f ? std::exp2(std::ceil(std::log2(half / 32766.0f))) : 1.0f;
+        offset[a] = std::round((lo[a] + half) / step[a]) * step[a];
+    }
+
+    std::vector<PackedVertex> packed(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const float* v = &data[i * 8];
+        PackedVertex& out = packed[i];
+        for (int a = 0; a < 3; ++a)
+            out.pos[a] = std::int16_t(std::clamp<long>(std::lround((v[a] - offset[a]) / step[a]), -32767, 32767));
+        out.pos[3] = 0;
+        out.normal = glm::packSnorm3x10_1x2(glm::vec4(v[3], v[4], v[5], 0.0f));
+        out.uv     = glm::packHalf2x16(glm::vec2(v[6], v[7]));
+    }
+    return packed;
+}
+
+// Divisor for attributes read once per mesh: no draw has this many instances
+constexpr GLuint kPerMeshDivisor = 0x7fffffff;
+
+} // namespace
+
+Mesh::Mesh(const std::string& objPath, VertexFormat format) : format(format) {
     // Log the path and existence
     std::cout << "Trying to load OBJ at: " << objPath << std::endl;
     if (!std::filesystem::exists(objPath)) {
@@ -55,42 +142,65 @@ Mesh::Mesh(const std::string& objPath) {
             }
         }
     }
+    upload(data);
+    std::cout << "Extracted " << indexCount << " vertices from OBJ, "
+              << vertexCount << " unique." << std::endl;
+}
+
+Mesh::Mesh(const std::vector<float>& vertices, VertexFormat format) : format(format) {
+    upload(vertices);
+}
+
+void Mesh::upload(const std::vector<float>& list) {
+    std::vector<float> data;
+    std::vector<std::uint32_t> indices;
+    deduplicate(list, data, indices);
     vertexCount = static_cast<GLsizei>(data.size() / 8);
-    std::cout << "Extracted " << vertexCount << " vertices from OBJ." << std::endl;
+    indexCount  = static_cast<GLsizei>(indices.size());
 
-    // Create and fill VBO
+    // Create and fill VBO; packed positions decode as offset + scale * xyz
+    glm::vec3 scale(1.0f), offset(0.0f);
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+    if (format == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed = pack(data, scale, offset);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+    }
+
+    // Scale and offset, fed to every vertex as per-mesh attributes so the
+    // instanced and indirect paths need no extra uniforms
+    const glm::vec3 decode[2] = { scale, offset };
+    glGenBuffers(1, &decodeVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, decodeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(decode), decode, GL_STATIC_DRAW);
+
+    // 16-bit indices whenever they reach every vertex
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (vertexCount <= 65536) {
+        std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        indexSize = sizeof(std::uint16_t);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * indexSize, shortIndices.data(), GL_STATIC_DRAW);
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        indexSize = sizeof(std::uint32_t);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * indexSize, indices.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     // --- PLAIN VAO ---
     glGenVertexArrays(1, &VAO_plain);
     glBindVertexArray(VAO_plain);
-      glBindBuffer(GL_ARRAY_BUFFER, VBO);
-      // pos @loc0
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      // normal @loc1
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      // uv @loc2
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
+      bindVertexAttribs();
     glBindVertexArray(0);
 
     // --- INSTANCED VAO ---
     glGenVertexArrays(1, &VAO_inst);
     glBindVertexArray(VAO_inst);
-      glBindBuffer(GL_ARRAY_BUFFER, VBO);
-      // pos @loc0
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      // normal @loc1
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      // uv @loc2
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
+      bindVertexAttribs();
 
       // instance matrix @loc3-6 (4 vec4 columns)
       glGenBuffers(1, &instanceVBO);
@@ -110,8 +220,62 @@ Mesh::Mesh(const std::string& objPath) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void Mesh::bindVertexAttribs() {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (format == VertexFormat::Packed) {
+        const GLsizei stride = sizeof(PackedVertex);
+        // pos @loc0: int16 steps, converted as is
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, stride, (void*)offsetof(PackedVertex, pos));
+        // normal @loc1
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        // uv @loc2
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, uv));
+    } else {
+        // pos @loc0
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        // normal @loc1
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        // uv @loc2
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    // position scale @loc7, offset @loc8
+    glBindBuffer(GL_ARRAY_BUFFER, decodeVBO);
+    for (int i = 0; i < 2; ++i) {
+        glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, 0, (void*)(i * sizeof(glm::vec3)));
+        glVertexAttribDivisor(7 + i, kPerMeshDivisor);
+        glEnableVertexAttribArray(7 + i);
+    }
+}
+
+std::vector<glm::vec3> Mesh::loadTriangles(const std::string& objPath) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objPath.c_str())) {
+        throw std::runtime_error("Failed to load OBJ: " + warn + err);
+    }
+
+    std::vector<glm::vec3> soup;
+    for (auto& shape : shapes) {
+        for (auto& idx : shape.mesh.indices) {
+            soup.emplace_back(attrib.vertices[3*idx.vertex_index+0],
+                              attrib.vertices[3*idx.vertex_index+1],
+                              attrib.vertices[3*idx.vertex_index+2]);
+        }
+    }
+    return soup;
+}
+
 Mesh::~Mesh() {
     if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
+    if (decodeVBO)   glDeleteBuffers(1, &decodeVBO);
+    if (EBO)         glDeleteBuffers(1, &EBO);
     if (VBO)         glDeleteBuffers(1, &VBO);
     if (VAO_inst)    glDeleteVertexArrays(1, &VAO_inst);
     if (VAO_plain)   glDeleteVertexArrays(1, &VAO_plain);
@@ -126,14 +290,64 @@ void Mesh::setInstanceBuffer(const std::vector<glm::mat4>& instanceData) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void Mesh::reserveInstanceBuffer(std::size_t maxInstances) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, maxInstances * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::updateInstanceRange(std::size_t first, const std::vector<glm::mat4>& instanceData) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    first * sizeof(glm::mat4),
+                    instanceData.size() * sizeof(glm::mat4),
+                    instanceData.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Mesh::drawPlain() {
     glBindVertexArray(VAO_plain);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, nullptr);
+    glBindVertexArray(0);
+}
+
+void Mesh::drawPlainRanges(const std::vector<GLint>& first, const std::vector<GLsizei>& count) {
+    if (first.empty()) return;
+    rangeOffsets.resize(first.size());
+    for (std::size_t i = 0; i < first.size(); ++i)
+        rangeOffsets[i] = reinterpret_cast<const void*>(std::size_t(first[i]) * indexSize);
+    glBindVertexArray(VAO_plain);
+    glMultiDrawElements(GL_TRIANGLES, count.data(), indexType, rangeOffsets.data(), static_cast<GLsizei>(first.size()));
     glBindVertexArray(0);
 }
 
 void Mesh::drawInstanced(GLsizei instanceCount) {
+    drawInstancedRange(0, instanceCount);
+}
+
+void Mesh::drawInstancedRange(std::size_t first, GLsizei instanceCount) {
     glBindVertexArray(VAO_inst);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
+    // GL 3.3 has no base instance, so point the matrix attribs at the range
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(first * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+    }
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, nullptr, instanceCount);
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::drawIndirect(GLuint instanceBuffer, GLuint commandBuffer) {
+    glBindVertexArray(VAO_inst);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(i * sizeof(glm::vec4)));
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
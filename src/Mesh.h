@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
@@ -7,28 +8,82 @@
 
 class Mesh {
 public:
+    // Vertex layout in the GPU buffer, chosen per mesh at load time
+    enum class VertexFormat {
+        Float,    // 32 bytes: float position, normal, uv
+        Packed,   // 16 bytes: int16 position (per-mesh scale and offset),
+                  // 10-10-10-2 normal, half-float uv
+    };
+
     // Load a mesh from an OBJ file
-    Mesh(const std::string& objPath);
+    Mesh(const std::string& objPath, VertexFormat format = VertexFormat::Float);
+    // Use a triangle list already in memory: position, normal, uv (8 floats)
+    // per vertex, as LevelMesh builds
+    explicit Mesh(const std::vector<float>& vertices, VertexFormat format = VertexFormat::Float);
     ~Mesh();
 
     // Draw without instancing (e.g., floor)
     void drawPlain();
 
+    // Draw ranges [first[i], first[i] + count[i]) of the triangle list the
+    // mesh was built from, in one call
+    void drawPlainRanges(const std::vector<GLint>& first, const std::vector<GLsizei>& count);
+
     // Draw with instancing (e.g., walls)
     void drawInstanced(GLsizei instanceCount);
 
+    // Draw instances [first, first + instanceCount) of the instance buffer
+    void drawInstancedRange(std::size_t first, GLsizei instanceCount);
+
+    // Draw with model matrices from instanceBuffer and the count from the
+    // DrawElementsIndirectCommand in commandBuffer (GL 4.0+; see GpuCuller)
+    void drawIndirect(GLuint instanceBuffer, GLuint commandBuffer);
+
+    // Indices per instance (triangle count * 3)
+    GLsizei getIndexCount() const { return indexCount; }
+    // Unique vertices in the vertex buffer
+    GLsizei getVertexCount() const { return vertexCount; }
+
+    // Load an OBJ's positions as a triangle soup (3 per triangle) for CPU-side
+    // use such as collision; nothing is uploaded
+    static std::vector<glm::vec3> loadTriangles(const std::string& objPath);
+
     // Upload per-instance model matrices
     void setInstanceBuffer(const std::vector<glm::mat4>& instanceData);
 
+    // Allocate room for maxInstances matrices (contents undefined) to be
+    // filled piecewise with updateInstanceRange
+    void reserveInstanceBuffer(std::size_t maxInstances);
+
+    // Overwrite instances [first, first + instanceData.size())
+    void updateInstanceRange(std::size_t first, const std::vector<glm::mat4>& instanceData);
+
 private:
+    // Merge repeated vertices of an interleaved triangle list, then create
+    // the VBO, the index buffer and both VAOs
+    void upload(const std::vector<float>& list);
+    // Point locations 0-2 and 7-8 of the bound VAO at this mesh's buffers
+    void bindVertexAttribs();
+
+    VertexFormat format = VertexFormat::Float;
     // VAO for non-instanced draws
     GLuint VAO_plain   = 0;
     // VAO for instanced draws
     GLuint VAO_inst    = 0;
     // Vertex buffer for mesh data (positions, normals)
     GLuint VBO         = 0;
+    // Position scale and offset, one of each per mesh
+    GLuint decodeVBO   = 0;
+    // Index buffer, 16-bit when every vertex fits
+    GLuint EBO         = 0;
+    GLenum indexType   = GL_UNSIGNED_SHORT;
+    std::size_t indexSize = 2;
     // Instance buffer for model matrices
     GLuint instanceVBO = 0;
-    // Number of vertices (triangle count * 3)
+    // Number of unique vertices
     GLsizei vertexCount = 0;
+    // Number of indices (triangle count * 3)
+    GLsizei indexCount = 0;
+    // Byte offsets for drawPlainRanges, kept to avoid allocating per frame
+    std::vector<const void*> rangeOffsets;
 };
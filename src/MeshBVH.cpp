@@ -0,0 +1,382 @@
+// src/MeshBVH.cpp
+#include "MeshBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr int           kBins        = 16;
+constexpr std::uint32_t kMaxLeafTris = 4;
+// Past kSahDepth nodes split at the centroid median, which halves them, so
+// no leaf lies deeper than kMaxDepth however skewed the SAH splits were.
+// Traversal stacks hold at most one pending node per level plus one.
+constexpr std::uint32_t kSahDepth    = 32;
+constexpr std::uint32_t kMaxDepth    = kSahDepth + 32;
+constexpr float         kInf         = std::numeric_limits<float>::infinity();
+
+float surfaceArea(const glm::vec3& bmin, const glm::vec3& bmax) {
+    glm::vec3 e = bmax - bmin;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+// Closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a,
+                                 const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Squared distance from p to the box [bmin, bmax]
+float distSqToBox(const glm::vec3& p, const glm::vec3& bmin, const glm::vec3& bmax) {
+    glm::vec3 q = glm::clamp(p, bmin, bmax);
+    return glm::dot(p - q, p - q);
+}
+
+// Slab test of origin + t * dir (t in [0, tMax]) against a box; returns entry t or kInf
+float rayBoxEntry(const glm::vec3& origin, const glm::vec3& invDir,
+                  const glm::vec3& bmin, const glm::vec3& bmax, float tMax) {
+    glm::vec3 t0 = (bmin - origin) * invDir;
+    glm::vec3 t1 = (bmax - origin) * invDir;
+    glm::vec3 lo = glm::min(t0, t1), hi = glm::max(t0, t1);
+    float tNear = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+    float tFar  = std::min(std::min(hi.x, hi.y), std::min(hi.z, tMax));
+    return tNear <= tFar ? tNear : kInf;
+}
+
+glm::vec3 safeInverse(const glm::vec3& d) {
+    auto inv = [](float v) { return std::abs(v) > 1e-12f ? 1.0f / v : (v < 0.0f ? -kInf : kInf); };
+    return { inv(d.x), inv(d.y), inv(d.z) };
+}
+
+// Smallest t >= 0 with |m + d t| = r for a sphere starting outside (|m| > r);
+// kInf when it never gets there
+float raySphere(const glm::vec3& m, const glm::vec3& d, float r) {
+    float a = glm::dot(d, d);
+    float b = glm::dot(m, d);
+    float c = glm::dot(m, m) - r * r;
+    if (a < 1e-12f || b >= 0.0f) return kInf;
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return kInf;
+    return (-b - std::sqrt(disc)) / a;
+}
+
+// First t in [0, 1] at which a sphere moving start -> start + delta touches
+// the triangle. The caller has already rejected spheres overlapping at t = 0.
+float sweepSphereTriangle(const glm::vec3& start, const glm::vec3& delta, float r,
+                          const MeshBVH::Triangle& tri) {
+    float best = kInf;
+    const glm::vec3* v[3] = { &tri.v0, &tri.v1, &tri.v2 };
+
+    // Face interior: the sphere's leading point crosses the plane inside the triangle
+    glm::vec3 n = glm::cross(tri.v1 - tri.v0, tri.v2 - tri.v0);
+    float nLen = glm::length(n);
+    if (nLen > 1e-12f) {
+        n /= nLen;
+        float dist = glm::dot(start - tri.v0, n);
+        float side = dist >= 0.0f ? 1.0f : -1.0f;
+        float approach = glm::dot(delta, n) * side;
+        if (std::abs(dist) >= r && approach < 0.0f) {
+            float t = (std::abs(dist) - r) / -approach;
+            glm::vec3 contact = start + delta * t - n * (side * r);
+            glm::vec3 c0 = glm::cross(tri.v1 - tri.v0, contact - tri.v0);
+            glm::vec3 c1 = glm::cross(tri.v2 - tri.v1, contact - tri.v1);
+            glm::vec3 c2 = glm::cross(tri.v0 - tri.v2, contact - tri.v2);
+            glm::vec3 fn = n * nLen;
+            if (glm::dot(c0, fn) >= 0.0f && glm::dot(c1, fn) >= 0.0f && glm::dot(c2, fn) >= 0.0f)
+                best = t;
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec3& a = *v[i];
+        const glm::vec3& b = *v[(i + 1) % 3];
+
+        // Vertex: ray against a sphere of radius r around it
+        best = std::min(best, raySphere(start - a, delta, r));
+
+        // Edge: ray against a cylinder of radius r around the segment
+        glm::vec3 e = b - a, m = start - a;
+        float ee = glm::dot(e, e), md = glm::dot(m, e), dd = glm::dot(delta, e);
+        float qa = ee * glm::dot(delta, delta) - dd * dd;
+        float qb = ee * glm::dot(m, delta) - md * dd;
+        float qc = ee * (glm::dot(m, m) - r * r) - md * md;
+        if (qa < 1e-12f || qc < 0.0f) continue;
+        float disc = qb * qb - qa * qc;
+        if (disc < 0.0f) continue;
+        float t = (-qb - std::sqrt(disc)) / qa;
+        if (t < 0.0f) continue;
+        float u = (md + dd * t) / ee;
+        if (u >= 0.0f && u <= 1.0f) best = std::min(best, t);
+    }
+    return best <= 1.0f ? std::max(best, 0.0f) : kInf;
+}
+
+} // namespace
+
+void MeshBVH::addMesh(const std::vector<glm::vec3>& soup, const glm::mat4& transform) {
+    tris.reserve(tris.size() + soup.size() / 3);
+    for (std::size_t i = 0; i + 2 < soup.size(); i += 3) {
+        Triangle t;
+        t.v0 = glm::vec3(transform * glm::vec4(soup[i + 0], 1.0f));
+        t.v1 = glm::vec3(transform * glm::vec4(soup[i + 1], 1.0f));
+        t.v2 = glm::vec3(transform * glm::vec4(soup[i + 2], 1.0f));
+        tris.push_back(t);
+    }
+}
+
+void MeshBVH::build() {
+    nodes.clear();
+    if (tris.empty()) return;
+    nodes.reserve(tris.size() * 2);
+
+    std::vector<glm::vec3> centroids(tris.size());
+    for (std::size_t i = 0; i < tris.size(); ++i)
+        centroids[i] = (tris[i].v0 + tris[i].v1 + tris[i].v2) * (1.0f / 3.0f);
+    buildNode(0, (std::uint32_t)tris.size(), centroids, 0);
+}
+
+std::uint32_t MeshBVH::buildNode(std::uint32_t first, std::uint32_t count,
+                                 std::vector<glm::vec3>& centroids, std::uint32_t depth) {
+    std::uint32_t index = (std::uint32_t)nodes.size();
+    nodes.push_back({});
+
+    glm::vec3 bmin(kInf), bmax(-kInf), cmin(kInf), cmax(-kInf);
+    for (std::uint32_t i = first; i < first + count; ++i) {
+        const Triangle& t = tris[i];
+        bmin = glm::min(bmin, glm::min(t.v0, glm::min(t.v1, t.v2)));
+        bmax = glm::max(bmax, glm::max(t.v0, glm::max(t.v1, t.v2)));
+        cmin = glm::min(cmin, centroids[i]);
+        cmax = glm::max(cmax, centroids[i]);
+    }
+    auto makeLeaf = [&] {
+        nodes[index] = { bmin, first, bmax, count };
+        return index;
+    };
+    auto makeInterior = [&](std::uint32_t mid) {
+        buildNode(first, mid - first, centroids, depth + 1);   // left child lands at index + 1
+        std::uint32_t right = buildNode(mid, first + count - mid, centroids, depth + 1);
+        nodes[index] = { bmin, right, bmax, 0 };
+        return index;
+    };
+    if (count <= kMaxLeafTris || depth >= kMaxDepth) return makeLeaf();
+    if (depth >= kSahDepth) {
+        // Deep in a skewed tree: halve at the centroid median of the widest axis
+        const glm::vec3 extent = cmax - cmin;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        if (extent[axis] <= 0.0f) return makeLeaf();
+        std::vector<std::uint32_t> order(count);
+        for (std::uint32_t i = 0; i < count; ++i) order[i] = first + i;
+        std::nth_element(order.begin(), order.begin() + count / 2, order.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        std::vector<Triangle>  sortedTris(count);
+        std::vector<glm::vec3> sortedCentroids(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            sortedTris[i] = tris[order[i]];
+            sortedCentroids[i] = centroids[order[i]];
+        }
+        std::copy(sortedTris.begin(), sortedTris.end(), tris.begin() + first);
+        std::copy(sortedCentroids.begin(), sortedCentroids.end(), centroids.begin() + first);
+        return makeInterior(first + count / 2);
+    }
+
+    // Binned SAH: bucket centroids along each axis and pick the cheapest split plane
+    struct Bin {
+        glm::vec3     bmin = glm::vec3(kInf), bmax = glm::vec3(-kInf);
+        std::uint32_t count = 0;
+    };
+    int   bestAxis = -1, bestSplit = 0;
+    float bestCost = surfaceArea(bmin, bmax) * count;   // cost of not splitting
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = cmax[axis] - cmin[axis];
+        if (extent <= 0.0f) continue;
+        float scale = kBins / extent;
+
+        Bin bins[kBins];
+        for (std::uint32_t i = first; i < first + count; ++i) {
+            int b = std::min(kBins - 1, (int)((centroids[i][axis] - cmin[axis]) * scale));
+            const Triangle& t = tris[i];
+            bins[b].bmin = glm::min(bins[b].bmin, glm::min(t.v0, glm::min(t.v1, t.v2)));
+            bins[b].bmax = glm::max(bins[b].bmax, glm::max(t.v0, glm::max(t.v1, t.v2)));
+            ++bins[b].count;
+        }
+
+        // Sweep from both ends to get left/right areas for every plane
+        float leftArea[kBins - 1], rightArea[kBins - 1];
+        std::uint32_t leftCount[kBins - 1], rightCount[kBins - 1];
+        glm::vec3 lmin(kInf), lmax(-kInf), rmin(kInf), rmax(-kInf);
+        std::uint32_t lsum = 0, rsum = 0;
+        for (int i = 0; i < kBins - 1; ++i) {
+            lsum += bins[i].count;
+            leftCount[i] = lsum;
+            lmin = glm::min(lmin, bins[i].bmin);
+            lmax = glm::max(lmax, bins[i].bmax);
+            leftArea[i] = lsum ? surfaceArea(lmin, lmax) : 0.0f;
+
+            int j = kBins - 1 - i;
+            rsum += bins[j].count;
+            rightCount[j - 1] = rsum;
+            rmin = glm::min(rmin, bins[j].bmin);
+            rmax = glm::max(rmax, bins[j].bmax);
+            rightArea[j - 1] = rsum ? surfaceArea(rmin, rmax) : 0.0f;
+        }
+        for (int i = 0; i < kBins - 1; ++i) {
+            if (!leftCount[i] || !rightCount[i]) continue;
+            float cost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+            if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = i; }
+        }
+    }
+    if (bestAxis < 0) return makeLeaf();
+
+    // Partition triangles (and their centroids) around the chosen plane
+    float scale = kBins / (cmax[bestAxis] - cmin[bestAxis]);
+    std::uint32_t mid = first;
+    for (std::uint32_t i = first; i < first + count; ++i) {
+        int b = std::min(kBins - 1, (int)((centroids[i][bestAxis] - cmin[bestAxis]) * scale));
+        if (b <= bestSplit) {
+            std::swap(tris[i], tris[mid]);
+            std::swap(centroids[i], centroids[mid]);
+            ++mid;
+        }
+    }
+
+    return makeInterior(mid);
+}
+
+bool MeshBVH::collides(const glm::vec3& pos, float radius) const {
+    if (nodes.empty()) return false;
+    const float r2 = radius * radius;
+    std::uint32_t stack[kMaxDepth + 1];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        const Node& node = nodes[stack[--sp]];
+        if (distSqToBox(pos, node.bmin, node.bmax) > r2) continue;
+        if (node.count) {
+            for (std::uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; ++i) {
+                const Triangle& t = tris[i];
+                glm::vec3 d = pos - closestPointOnTriangle(pos, t.v0, t.v1, t.v2);
+                if (glm::dot(d, d) <= r2) return true;
+            }
+        } else {
+            std::uint32_t self = std::uint32_t(&node - nodes.data());
+            stack[sp++] = node.rightOrFirst;
+            stack[sp++] = self + 1;
+        }
+    }
+    return false;
+}
+
+SweepHit MeshBVH::sweep(const glm::vec3& start, const glm::vec3& delta, float radius) const {
+    SweepHit hit;
+    if (nodes.empty()) return hit;
+    const glm::vec3 invDelta = safeInverse(delta);
+    const glm::vec3 grow(radius);
+    const float r2 = radius * radius;
+
+    std::uint32_t stack[kMaxDepth + 1];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        std::uint32_t ni = stack[--sp];
+        const Node& node = nodes[ni];
+        if (rayBoxEntry(start, invDelta, node.bmin - grow, node.bmax + grow, hit.toi) == kInf)
+            continue;
+        if (node.count) {
+            for (std::uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; ++i) {
+                const Triangle& t = tris[i];
+                glm::vec3 d0 = start - closestPointOnTriangle(start, t.v0, t.v1, t.v2);
+                if (glm::dot(d0, d0) <= r2) continue;   // already touching: let it escape
+                float toi = sweepSphereTriangle(start, delta, radius, t);
+                if (toi >= hit.toi) continue;
+                glm::vec3 p = start + delta * toi;
+                glm::vec3 n = p - closestPointOnTriangle(p, t.v0, t.v1, t.v2);
+                float len = glm::length(n);
+                hit.hit = true;
+                hit.toi = toi;
+                hit.normal = len > 0.0f ? n / len : -glm::normalize(delta);
+            }
+        } else {
+            stack[sp++] = node.rightOrFirst;
+            stack[sp++] = ni + 1;
+        }
+    }
+    return hit;
+}
+
+RayHit MeshBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDist) const {
+    RayHit hit;
+    float len = glm::length(direction);
+    if (nodes.empty() || len <= 0.0f || maxDist <= 0.0f) return hit;
+    const glm::vec3 dir = direction / len;
+    const glm::vec3 invDir = safeInverse(dir);
+    float tBest = maxDist;
+
+    std::uint32_t stack[kMaxDepth + 1];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        const Node& node = nodes[stack[--sp]];
+        if (node.count) {
+            // Moller-Trumbore, double-sided
+            for (std::uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; ++i) {
+                const Triangle& t = tris[i];
+                glm::vec3 e1 = t.v1 - t.v0, e2 = t.v2 - t.v0;
+                glm::vec3 p = glm::cross(dir, e2);
+                float det = glm::dot(e1, p);
+                if (std::abs(det) < 1e-12f) continue;
+                float inv = 1.0f / det;
+                glm::vec3 s = origin - t.v0;
+                float u = glm::dot(s, p) * inv;
+                if (u < 0.0f || u > 1.0f) continue;
+                glm::vec3 q = glm::cross(s, e1);
+                float v = glm::dot(dir, q) * inv;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                float tHit = glm::dot(e2, q) * inv;
+                if (tHit < 0.0f || tHit > tBest) continue;
+
+                tBest = tHit;
+                glm::vec3 n = glm::normalize(glm::cross(e1, e2));
+                hit.hit = true;
+                hit.distance = tHit;
+                hit.normal = glm::dot(n, dir) > 0.0f ? -n : n;
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so tBest shrinks early
+        std::uint32_t self = std::uint32_t(&node - nodes.data());
+        std::uint32_t a = self + 1, b = node.rightOrFirst;
+        float ta = rayBoxEntry(origin, invDir, nodes[a].bmin, nodes[a].bmax, tBest);
+        float tb = rayBoxEntry(origin, invDir, nodes[b].bmin, nodes[b].bmax, tBest);
+        if (ta > tb) { std::swap(ta, tb); std::swap(a, b); }
+        if (tb != kInf) stack[sp++] = b;
+        if (ta != kInf) stack[sp++] = a;
+    }
+    if (hit.hit) hit.point = origin + dir * hit.distance;
+    return hit;
+}
@@ -0,0 +1,198 @@
+// src/PathService.cpp
+#include "PathService.h"
+#include "FlowField.h"
+#include "Map.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Cells from start down the field's steps to its goal; false if unreached
+bool readPath(const FlowField& field, glm::ivec2 start, std::vector<glm::ivec2>& path) {
+    path.clear();
+    if (field.cost(start.x, start.y) == FlowField::kUnreached) return false;
+    path.push_back(start);
+    for (glm::ivec2 c = start; c != field.goal(); ) {
+        c = field.nextCell(c.x, c.y);
+        path.push_back(c);
+    }
+    return true;
+}
+
+} // namespace
+
+PathService::PathService(const Map& map, ThreadPool& pool, Solver solve, const Settings& s)
+    : map(map), pool(pool), solve(std::move(solve)), settings(s), state(std::make_shared<State>()) {
+    if (settings.maxJobs == 0) settings.maxJobs = std::max(pool.size(), 1u);
+    settings.fieldSlice = std::max<std::size_t>(settings.fieldSlice, 1);
+}
+
+PathService::~PathService() {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->stopping = true;
+    state->queue.clear();
+    state->waiting.clear();
+    state->idle.wait(lock, [this] { return state->inFlight == 0; });
+}
+
+PathService::Ticket PathService::request(glm::ivec2 start, glm::ivec2 goal) {
+    const Ticket ticket = nextTicket++;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    Entry& e = state->entries[ticket];
+    e.start = start;
+
+    // Join the waiting group for this goal, or start one at the back
+    auto it = state->waiting.find(goalKey(goal));
+    if (it != state->waiting.end()) {
+        it->second->tickets.push_back(ticket);
+        return ticket;
+    }
+    auto group = std::make_unique<Group>();
+    group->goal = goal;
+    group->tickets.push_back(ticket);
+    state->waiting[goalKey(goal)] = group.get();
+    state->queue.push_back(std::move(group));
+    return ticket;
+}
+
+void PathService::cancel(Ticket ticket) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->entries.erase(ticket);
+}
+
+void PathService::tick() {
+    int start;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->queue.empty()) return;
+        start = std::min<int>(int(settings.maxJobs) - state->inFlight, int(state->queue.size()));
+        if (start <= 0) return;
+        state->inFlight += start;
+    }
+    const double share = settings.budgetMs / settings.maxJobs;
+    for (int i = 0; i < start; ++i) {
+        pool.submit([st = state, &map = map, &solve = solve, settings = settings, share] {
+            runJob(st, map, solve, settings, share);
+        });
+    }
+}
+
+PathService::Status PathService::take(Ticket ticket, std::vector<glm::ivec2>& path) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto it = state->entries.find(ticket);
+    if (it == state->entries.end()) return Status::Unknown;
+    const Status status = it->second.status;
+    if (status == Status::Pending) return status;
+    path = std::move(it->second.path);
+    state->entries.erase(it);
+    return status;
+}
+
+std::size_t PathService::pendingCount() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return std::size_t(std::count_if(state->entries.begin(), state->entries.end(),
+        [](const auto& kv) { return kv.second.status == Status::Pending; }));
+}
+
+void PathService::runJob(const std::shared_ptr<State>& st, const Map& map, const Solver& solve,
+                         const Settings& settings, double budgetMs) {
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double, std::milli>(budgetMs));
+
+    // Store a result unless the request was cancelled meanwhile
+    auto publish = [&](Ticket t, bool found, std::vector<glm::ivec2>& path) {
+        std::lock_guard<std::mutex> lock(st->mutex);
+        auto it = st->entries.find(t);
+        if (it == st->entries.end()) return;
+        it->second.status = found ? Status::Found : Status::NoPath;
+        it->second.path   = std::move(path);
+    };
+    // Put unfinished work back at the front for the next tick, taking over
+    // requests for the same goal that arrived meanwhile (their group is left
+    // empty and skipped)
+    auto requeue = [&](std::unique_ptr<Group> group) {
+        std::lock_guard<std::mutex> lock(st->mutex);
+        if (st->stopping) return;
+        Group*& slot = st->waiting[goalKey(group->goal)];
+        if (slot) {
+            group->tickets.insert(group->tickets.end(), slot->tickets.begin(), slot->tickets.end());
+            slot->tickets.clear();
+        }
+        slot = group.get();
+        st->queue.push_front(std::move(group));
+    };
+
+    std::vector<std::pair<Ticket, glm::ivec2>> work;
+    std::vector<glm::ivec2> path;
+    while (Clock::now() < deadline) {
+        std::unique_ptr<Group> group;
+        work.clear();
+        {
+            std::lock_guard<std::mutex> lock(st->mutex);
+            if (st->stopping || st->queue.empty()) break;
+            group = std::move(st->queue.front());
+            st->queue.pop_front();
+            auto it = st->waiting.find(goalKey(group->goal));
+            if (it != st->waiting.end() && it->second == group.get()) st->waiting.erase(it);
+            for (Ticket t : group->tickets) {
+                auto e = st->entries.find(t);
+                if (e != st->entries.end()) work.push_back({ t, e->second.start });
+            }
+        }
+        if (work.empty()) continue;
+
+        if (group->field || work.size() >= settings.coalesceAt) {
+            // One search from the goal answers every request in the group
+            if (!group->field) {
+                group->field = std::make_unique<FlowField>();
+                group->field->reset(map);
+                group->field->setGoal(map, group->goal);
+            }
+            FlowField& field = *group->field;
+            while (field.pending() && Clock::now() < deadline) field.advance(map, settings.fieldSlice);
+            if (field.pending()) {
+                requeue(std::move(group));
+                break;
+            }
+            for (auto [t, start] : work) {
+                const bool found = readPath(field, start, path);
+                publish(t, found, path);
+            }
+            continue;
+        }
+
+        // Identical starts sit together and share one search
+        std::sort(work.begin(), work.end(), [](const auto& a, const auto& b) {
+            return a.second.y != b.second.y ? a.second.y < b.second.y : a.second.x < b.second.x;
+        });
+        bool solved = false, found = false;
+        glm::ivec2 solvedStart;
+        for (std::size_t i = 0; i < work.size(); ++i) {
+            if (i > 0 && Clock::now() >= deadline) {
+                group->tickets.clear();
+                for (std::size_t j = i; j < work.size(); ++j) group->tickets.push_back(work[j].first);
+                requeue(std::move(group));
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(st->mutex);
+                if (!st->entries.count(work[i].first)) continue;   // cancelled
+            }
+            if (!solved || work[i].second != solvedStart) {
+                found       = solve(work[i].second, group->goal, path);
+                solved      = true;
+                solvedStart = work[i].second;
+            }
+            std::vector<glm::ivec2> result = found ? path : std::vector<glm::ivec2>();
+            publish(work[i].first, found, result);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(st->mutex);
+    if (--st->inFlight == 0) st->idle.notify_all();
+}
@@ -0,0 +1,86 @@
+// src/ThreadPool.cpp
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t)>& body) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    // Helpers may be dequeued after the loop has finished; they then find no
+    // chunk left and never touch body, so only the shared state must outlive us.
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::mutex               mutex;
+        std::condition_variable  finished;
+    };
+    auto state = std::make_shared<State>();
+    auto run = [state, chunks, count, grain, &body] {
+        std::size_t ran = 0;
+        for (std::size_t c; (c = state->next.fetch_add(1)) < chunks; ++ran) {
+            std::size_t begin = c * grain;
+            body(begin, std::min(count, begin + grain));
+        }
+        if (ran && state->done.fetch_add(ran) + ran == chunks) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished.notify_all();
+        }
+    };
+
+    std::size_t helpers = std::min<std::size_t>(workers.size(), chunks - 1);
+    for (std::size_t i = 0; i < helpers; ++i) submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == chunks; });
+}
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <utility>
 
 #define SDL_MAIN_HANDLED
 #include <SDL2/SDL.h>
@@ -25,17 +26,51 @@
 
 #include "Mesh.h"
 #include "Map.h"
+#include "AgentResolver.h"
+#include "ChunkStreamer.h"
 #include "CollisionGrid.h"
+#include "DistanceField.h"
+#include "FlowField.h"
+#include "Frustum.h"
+#include "GpuCuller.h"
+#include "LevelMesh.h"
 #include "Material.h"
+#include "PotentiallyVisibleSet.h"
+#include "ThreadPool.h"
 
 namespace Config {
     constexpr int WINDOW_WIDTH  = 800;
     constexpr int WINDOW_HEIGHT = 600;
     constexpr char APP_NAME[]   = "IWEngine";
+    constexpr float FOV_Y       = 60.0f;    // degrees
+    constexpr float NEAR_PLANE  = 0.1f;
+    constexpr float FAR_PLANE   = 100.0f;
 }
 
 constexpr float WALL_HEIGHT   = 3.0f;
 constexpr float PLAYER_RADIUS = 0.45f;
+// Larger maps skip the distance field (16 bytes per cell) and always sweep
+constexpr std::size_t DISTANCE_FIELD_MAX_CELLS = std::size_t(1) << 22;
+constexpr float ZOMBIE_RADIUS = 0.35f;
+constexpr float ZOMBIE_SPEED  = 2.0f;
+// The visibility bake lights the view circle from every floor cell. Its
+// cost follows how much each cell sees, not the map size: corridor maps
+// bake in a fraction of a second, open arenas take ~0.1 ms and 300-700
+// bytes per floor cell. Past either budget it gives up and every streamed
+// wall is drawn.
+constexpr std::uint64_t PVS_MAX_EXAMINED = std::uint64_t(1) << 27;
+constexpr std::size_t   PVS_MAX_BYTES    = std::size_t(32) << 20;
+// Flow field cells settled per frame after the player changes cell
+constexpr std::size_t FLOW_CELLS_PER_FRAME = 1 << 16;
+// The flow field keeps a live and a back field (14 bytes per cell); past
+// this size zombies head straight for the player instead
+constexpr std::size_t FLOW_FIELD_MAX_CELLS = std::size_t(1) << 22;
+// GPU culling keeps every wall instance resident (16 bytes each); maps with
+// more merged walls than this stream chunks instead
+constexpr std::size_t GPU_CULL_MAX_INSTANCES = std::size_t(1) << 22;
+// The level mesh keeps every exposed wall face resident (up to ~80 bytes
+// per wall cell in a maze); larger maps draw instanced cubes instead
+constexpr std::size_t LEVEL_MESH_MAX_CELLS = std::size_t(1) << 18;
 
 static std::string readFile(const std::string& path) {
     std::ifstream in{path};
@@ -84,7 +119,8 @@ struct Camera {
         return glm::lookAt(pos, pos + glm::normalize(front), glm::vec3(0,1,0));
     }
 
-    void processKeyboard(const Uint8* keys, float dt, const CollisionGrid& grid) {
+    void processKeyboard(const Uint8* keys, float dt, const CollisionWorld& world,
+                         const DistanceField& field) {
         glm::vec3 front{
             cos(glm::radians(yaw)) * cos(glm::radians(pitch)),
             0.0f,
@@ -101,16 +137,12 @@ struct Camera {
         if (glm::length(move) > 0.0f)
             move = glm::normalize(move) * speed * dt;
 
-        glm::vec3 tryPos = pos + move;
-        glm::vec3 sphPos{tryPos.x, pos.y, tryPos.z};
-        if (!grid.collides(sphPos, PLAYER_RADIUS)) {
-            pos = tryPos;
-        } else {
-            sphPos = {pos.x + move.x, pos.y, pos.z};
-            if (!grid.collides(sphPos, PLAYER_RADIUS)) pos.x = sphPos.x;
-            sphPos = {pos.x, pos.y, pos.z + move.z};
-            if (!grid.collides(sphPos, PLAYER_RADIUS)) pos.z = sphPos.z;
-        }
+        // In open space the distance field proves the whole step is clear,
+        // so the sweep is only needed near walls
+        if (!field.empty() && field.isClear(pos, PLAYER_RADIUS + glm::length(move)))
+            pos += move;
+        else
+            pos = world.slide(pos, move, PLAYER_RADIUS);
     }
 
     void processMouse(int dx, int dy) {
@@ -122,6 +154,8 @@ struct Camera {
 
 class EngineApp {
 public:
+    explicit EngineApp(std::string mapPath) : mapPath(std::move(mapPath)) {}
+
     void run() {
         initWindow();
         initGL();
@@ -135,9 +169,27 @@ private:
     std::unique_ptr<Mesh>     mesh;
     std::unique_ptr<Material> wallMaterial;
     GLuint                    program      = 0;
+    std::string               mapPath;            // text or .t3vm, picked by content
     Map                       map;
-    std::vector<glm::vec3>    wallPositions;
+    ThreadPool                pool;
+    LevelMesh                 levelMesh;          // small maps: exposed faces in one static buffer
+    std::unique_ptr<Mesh>     levelGeometry;
+    std::vector<GLint>        levelFirst;         // chunk ranges drawn this frame
+    std::vector<GLsizei>      levelCount;
+    std::unique_ptr<GpuCuller> gpuCuller;         // GL 4.3+: walls culled and counted on the GPU
+    std::unique_ptr<ChunkStreamer> streamer;      // otherwise: chunks streamed and culled on the CPU
+    PotentiallyVisibleSet     pvs;
+    OccupancyGrid             visibleCells;      // decoded PVS of the camera's cell
+    glm::ivec2                visibleFrom{-1, -1};
+    bool                      visibleKnown = false;
     CollisionGrid             collisionGrid;
+    DistanceField             distanceField;
+    FlowField                 flowField;
+    AgentResolver             zombieResolver{&pool};
+    std::unique_ptr<Mesh>     zombieMesh;
+    std::vector<glm::vec3>    zombies;
+    std::vector<glm::vec3>    zombieSteps, zombieNext;
+    std::vector<glm::mat4>    zombieInst;         // rebuilt each frame, storage kept
     Camera                    camera;
     GLint                     uModelLoc    = -1;
     GLint                     uUseInstLoc  = -1;
@@ -154,7 +206,8 @@ private:
         if (SDL_Init(SDL_INIT_VIDEO) < 0)
             throw std::runtime_error("SDL_Init failed: " + std::string(SDL_GetError()));
 
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        // GL 4.3 enables GPU culling; 3.3 is enough for everything else
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
@@ -169,6 +222,11 @@ private:
         SDL_ShowWindow(window);
 
         glContext = SDL_GL_CreateContext(window);
+        if (!glContext) {
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+            glContext = SDL_GL_CreateContext(window);
+        }
         if (!glContext)
             throw std::runtime_error("SDL_GL_CreateContext failed: " + std::string(SDL_GetError()));
 
@@ -228,57 +286,114 @@ private:
         glUniform3f(uLightDirLoc, 1.0f, -1.0f,  0.0f);
 
         // load mesh & material
-        mesh         = std::make_unique<Mesh>(std::string(ASSET_DIR) + "/model.obj");
+        mesh         = std::make_unique<Mesh>(std::string(ASSET_DIR) + "/model.obj", Mesh::VertexFormat::Packed);
         wallMaterial = std::make_unique<Material>("", "", "", 32.0f);
 
-        if (!map.load("maps/map.txt"))
-            throw std::runtime_error("map load failed");
-
-        // build walls
-        for (int y = 0; y < (int)map.grid.size(); ++y) {
-            for (int x = 0; x < (int)map.grid[y].size(); ++x) {
-                if (map.grid[y][x] == '#') {
-                    wallPositions.emplace_back(
-                        x + 0.5f,
-                        0.0f,
-                        (map.grid.size() - 1 - y) + 0.5f
-                    );
-                }
+        if (!map.load(mapPath))
+            throw std::runtime_error("map load failed: " + mapPath);
+
+        // small maps mesh only the wall faces the camera can see, merged
+        // into long quads; the eye stays at y = 1, below every wall top
+        if (std::size_t(map.width()) * map.height() <= LEVEL_MESH_MAX_CELLS) {
+            LevelMesh::Settings meshing;
+            meshing.wallHeight = WALL_HEIGHT;
+            meshing.tops       = false;
+            levelMesh.build(map, meshing, &pool);
+            levelGeometry = std::make_unique<Mesh>(levelMesh.vertices(), Mesh::VertexFormat::Packed);
+        }
+
+        // with GL 4.3 every wall stays on the GPU, which culls it each frame
+        else if (GpuCuller::supported()) {
+            std::vector<WallRect> rects = mergeWallRects(map);
+            if (rects.size() <= GPU_CULL_MAX_INSTANCES) {
+                GpuCuller::Settings culling;
+                culling.wallHeight = WALL_HEIGHT;
+                gpuCuller = std::make_unique<GpuCuller>(readFile("../shader_sources/cull.comp.glsl"),
+                                                        readFile("../shader_sources/hiz.comp.glsl"), culling);
+                gpuCuller->upload(map, rects, mesh->getIndexCount());
             }
         }
 
-        // instance data
-        std::vector<glm::mat4> inst;
-        inst.reserve(wallPositions.size());
-        for (auto &p : wallPositions) {
-            glm::mat4 m = glm::translate(glm::mat4(1.0f), p);
-            m = glm::scale(m, glm::vec3(1.0f, WALL_HEIGHT, 1.0f));
-            inst.push_back(m);
+        // otherwise walls stream in by chunk around the camera; each
+        // resident chunk owns one slot of the instance buffer
+        if (!levelGeometry && !gpuCuller) {
+            ChunkStreamer::Settings streaming;
+            streaming.wallHeight = WALL_HEIGHT;
+            streamer = std::make_unique<ChunkStreamer>(map, pool, streaming);
+            mesh->reserveInstanceBuffer(streamer->slotCount() * streamer->slotCapacity());
         }
-        mesh->setInstanceBuffer(inst);
-        collisionGrid.build(wallPositions, WALL_HEIGHT);
+        if (!gpuCuller) {
+            // The far plane's corners are the farthest the frustum reaches:
+            // far / cos of the half-angle to a corner, plus a cell for where
+            // the camera stands in its own
+            const float tanY = std::tan(glm::radians(Config::FOV_Y) * 0.5f);
+            const float tanX = tanY * Config::WINDOW_WIDTH / Config::WINDOW_HEIGHT;
+            PotentiallyVisibleSet::Settings visibility;
+            visibility.maxDistance = int(std::ceil(Config::FAR_PLANE * std::sqrt(1 + tanX * tanX + tanY * tanY))) + 1;
+            visibility.maxExamined = PVS_MAX_EXAMINED;
+            visibility.maxBytes    = PVS_MAX_BYTES;
+            if (!pvs.bake(map, visibility, &pool))
+                std::cout << "Visibility bake over budget; drawing every streamed wall" << std::endl;
+        }
+
+        // tile-mode collision reads the map's occupancy bits directly, so it
+        // needs no per-chunk index
+        collisionGrid.build(map, WALL_HEIGHT);
+        if (std::size_t(map.width()) * map.height() <= DISTANCE_FIELD_MAX_CELLS)
+            distanceField.build(map);
 
         // spawn camera
         if (map.playerSpawn.x >= 0 && map.playerSpawn.y >= 0) {
-            camera.pos = glm::vec3(
-                map.playerSpawn.x + 0.5f,
-                1.0f,
-                (float)(map.grid.size() - 1 - map.playerSpawn.y) + 0.5f
-            );
-            float centerX = float(map.grid[0].size()) * 0.5f;
-            float centerZ = float(map.grid.size())     * 0.5f;
+            camera.pos = map.cellCenter(map.playerSpawn.x, map.playerSpawn.y, 1.0f);
+            float centerX = float(map.width())  * 0.5f;
+            float centerZ = float(map.height()) * 0.5f;
             float dx = centerX - camera.pos.x;
             float dz = centerZ - camera.pos.z;
             camera.yaw   = glm::degrees(std::atan2(dz, dx));
             camera.pitch = -20.0f;
         }
 
+        // zombies chase the player along the flow field
+        if (std::size_t(map.width()) * map.height() <= FLOW_FIELD_MAX_CELLS)
+            flowField.build(map, map.worldToCell(camera.pos));
+        zombieMesh = std::make_unique<Mesh>(std::string(ASSET_DIR) + "/model.obj", Mesh::VertexFormat::Packed);
+        for (const glm::ivec2& z : map.zombieSpawns)
+            zombies.push_back(map.cellCenter(z.x, z.y, 1.0f));
+        zombieInst.reserve(zombies.size());
+        zombieMesh->reserveInstanceBuffer(zombies.size());
+
         // --- Load floor textures ---
         floorAlbedo    = loadTexture(std::string(ASSET_DIR) + "/floor_diff.jpg");
         floorNormal    = loadTexture(std::string(ASSET_DIR) + "/floor_normal.png");
         floorRoughness = loadTexture(std::string(ASSET_DIR) + "/floor_rough.png");
     }
 
+    void moveZombies(float dt) {
+        const glm::ivec2 goal = flowField.goal();
+        zombieSteps.resize(zombies.size());
+        zombieNext.resize(zombies.size());
+        for (std::size_t i = 0; i < zombies.size(); ++i) {
+            // Head for the centre of the next cell on the path; in the
+            // player's cell there is no step left, so close in directly.
+            // Without a field, close in directly from anywhere.
+            glm::ivec2 cell = map.worldToCell(zombies[i]);
+            glm::ivec2 next = flowField.nextCell(cell.x, cell.y);
+            glm::vec3 dir(0.0f);
+            if (next != cell) {
+                glm::vec3 to = map.cellCenter(next.x, next.y, zombies[i].y) - zombies[i];
+                dir = glm::normalize(to);
+            } else if (cell == goal || flowField.empty()) {
+                glm::vec3 toPlayer(camera.pos.x - zombies[i].x, 0.0f, camera.pos.z - zombies[i].z);
+                float d = glm::length(toPlayer);
+                dir = d > PLAYER_RADIUS + ZOMBIE_RADIUS ? toPlayer / d : glm::vec3(0.0f);
+            }
+            zombieSteps[i] = dir * ZOMBIE_SPEED * dt;
+        }
+        const float radius = ZOMBIE_RADIUS;
+        zombieResolver.resolve(collisionGrid, zombies, zombieSteps, {&radius, 1}, zombieNext);
+        zombies.swap(zombieNext);
+    }
+
     void mainLoop() {
         SDL_Event e;
         Uint64 last = SDL_GetPerformanceCounter();
@@ -299,17 +414,44 @@ private:
                 if (e.type == SDL_MOUSEMOTION)
                     camera.processMouse(e.motion.xrel, e.motion.yrel);
             }
-            camera.processKeyboard(SDL_GetKeyboardState(nullptr), dt, collisionGrid);
+            camera.processKeyboard(SDL_GetKeyboardState(nullptr), dt, collisionGrid, distanceField);
+
+            // re-target the horde once the player enters a new cell; the
+            // search is spread over frames and never restarted midway
+            if (!flowField.empty()) {
+                flowField.setGoal(map, map.worldToCell(camera.pos));
+                flowField.advance(map, FLOW_CELLS_PER_FRAME);
+            }
+            moveZombies(dt);
+
+            glm::mat4 view = camera.getView();
+            glm::mat4 proj = glm::perspective(glm::radians(Config::FOV_Y),
+                                              float(Config::WINDOW_WIDTH) / Config::WINDOW_HEIGHT,
+                                              Config::NEAR_PLANE, Config::FAR_PLANE);
+
+            const std::size_t slotSize = streamer ? streamer->slotCapacity() : 0;
+            // only walls seen from the camera's cell go to the GPU
+            const glm::ivec2 cameraCell = map.worldToCell(camera.pos);
+            if (!pvs.empty() && cameraCell != visibleFrom) {
+                visibleFrom  = cameraCell;
+                visibleKnown = pvs.visibleFrom(cameraCell.x, cameraCell.y, visibleCells);
+                if (streamer) streamer->setVisibleCells(visibleKnown ? &visibleCells : nullptr);
+            }
+
+            if (gpuCuller) {
+                gpuCuller->cull(proj * view);
+            } else if (streamer) {
+                streamer->update(camera.pos);
+                streamer->upload([&](std::size_t slot, const std::vector<glm::mat4>& inst) {
+                    mesh->updateInstanceRange(slot * slotSize, inst);
+                });
+            }
 
             glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glUseProgram(program);
 
             // camera & lighting uniforms
-            glm::mat4 view = camera.getView();
-            glm::mat4 proj = glm::perspective(glm::radians(60.0f),
-                                              float(Config::WINDOW_WIDTH) / Config::WINDOW_HEIGHT,
-                                              0.1f, 100.0f);
             glUniformMatrix4fv(glGetUniformLocation(program, "uView"),       1, GL_FALSE, glm::value_ptr(view));
             glUniformMatrix4fv(glGetUniformLocation(program, "uProjection"), 1, GL_FALSE, glm::value_ptr(proj));
             glUniform3fv  (glGetUniformLocation(program, "uViewPos"),       1, glm::value_ptr(camera.pos));
@@ -326,33 +468,73 @@ private:
 
             // draw floor
             glm::mat4 floorM = glm::translate(glm::mat4(1.0f),
-                glm::vec3(map.grid[0].size() * 0.5f, 0.0f, map.grid.size() * 0.5f));
+                glm::vec3(map.width() * 0.5f, 0.0f, map.height() * 0.5f));
             floorM = glm::scale(floorM,
-                glm::vec3((float)map.grid[0].size(), 1.0f, (float)map.grid.size()));
+                glm::vec3((float)map.width(), 1.0f, (float)map.height()));
             glUniform1i(uUseInstLoc, 0);
             wallMaterial->bind(program);
             glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, glm::value_ptr(floorM));
             mesh->drawPlain();
 
-            // draw walls instanced
-            glUniform1i(uUseInstLoc, 1);
+            // draw walls: the level mesh's chunks in view in one multi-draw,
+            // or instanced, as the GPU's culled list in one indirect draw or
+            // one range per resident chunk in view
             wallMaterial->bind(program);
-            mesh->drawInstanced(static_cast<GLsizei>(wallPositions.size()));
+            if (levelGeometry) {
+                const Frustum frustum(proj * view);
+                levelFirst.clear();
+                levelCount.clear();
+                for (const LevelMesh::Chunk& c : levelMesh.chunks()) {
+                    if (!frustum.intersectsBox(c.lo, c.hi)) continue;
+                    if (visibleKnown && !visibleCells.anyInRect(c.x0, c.y0, c.x1, c.y1)) continue;
+                    levelFirst.push_back(static_cast<GLint>(c.first));
+                    levelCount.push_back(static_cast<GLsizei>(c.count));
+                }
+                glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+                levelGeometry->drawPlainRanges(levelFirst, levelCount);
+            }
+            glUniform1i(uUseInstLoc, 1);
+            if (gpuCuller) {
+                mesh->drawIndirect(gpuCuller->instanceBuffer(), gpuCuller->commandBuffer());
+            } else if (streamer) {
+                streamer->forEachResident(Frustum(proj * view), [&](std::size_t slot, std::size_t count) {
+                    mesh->drawInstancedRange(slot * slotSize, static_cast<GLsizei>(count));
+                });
+            }
+
+            // draw zombies
+            if (!zombies.empty()) {
+                zombieInst.clear();
+                for (const glm::vec3& z : zombies) {
+                    glm::mat4 m = glm::translate(glm::mat4(1.0f), z);
+                    zombieInst.push_back(glm::scale(m, glm::vec3(ZOMBIE_RADIUS, 1.0f, ZOMBIE_RADIUS)));
+                }
+                zombieMesh->updateInstanceRange(0, zombieInst);
+                zombieMesh->drawInstanced(static_cast<GLsizei>(zombieInst.size()));
+            }
+
+            // this frame's depth is the next frame's occluder set
+            if (gpuCuller)
+                gpuCuller->captureDepth(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT, proj * view);
 
             SDL_GL_SwapWindow(window);
         }
     }
 
     void cleanup() {
+        streamer.reset();
+        gpuCuller.reset();
+        levelGeometry.reset();
         SDL_GL_DeleteContext(glContext);
         SDL_DestroyWindow(window);
         SDL_Quit();
     }
 };
 
-int main() {
+// Usage: T3Vengine [map]   (text or .t3vm map, default maps/map.txt)
+int main(int argc, char** argv) {
     try {
-        EngineApp{}.run();
+        EngineApp(argc > 1 ? argv[1] : "maps/map.txt").run();
     } catch (const std::exception& ex) {
         std::cerr << "Fatal: " << ex.what() << std::endl;
         return EXIT_FAILURE;
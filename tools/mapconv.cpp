@@ -0,0 +1,29 @@
+// tools/mapconv.cpp
+// Convert an ASCII map (maps/map.txt style) into the binary .t3vm format.
+//   t3v_mapconv <input map> <output.t3vm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Map.h"
+#include "MapFormat.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <input map> <output.t3vm>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Map map;
+    if (!map.load(argv[1])) {
+        std::fprintf(stderr, "cannot load %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (!saveBinaryMap(map, argv[2])) {
+        std::fprintf(stderr, "cannot write %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    std::printf("%s: %dx%d, %zu walls, %zu zombie spawns -> %s\n",
+                argv[1], map.width(), map.height(), map.walls.count(),
+                map.zombieSpawns.size(), argv[2]);
+    return EXIT_SUCCESS;
+}